@@ -859,20 +859,28 @@ static inline int __ternary_cmp(int a, int b) {
     return 0;
 }
 
+/* The 00/01/10 codes are monotone, so packed words compare like their values
+ * once reserved 11 codes are folded to +1 (10). */
+static inline uint64_t ternary_compare_key(uint64_t packed) {
+    return packed & ~(packed & (packed >> 1) & 0x5555555555555555ULL);
+}
+
+static inline unsigned __int128 ternary_compare_key_u128(unsigned __int128 packed) {
+    const unsigned __int128 lsb = ((unsigned __int128)0x5555555555555555ULL << 64) |
+                                  0x5555555555555555ULL;
+    return packed & ~(packed & (packed >> 1) & lsb);
+}
+
 static inline int __ternary_cmp_t32(t32_t a, t32_t b) {
-    int64_t va = ternary_decode(a, 32);
-    int64_t vb = ternary_decode(b, 32);
-    if (va < vb) return -1;
-    if (va > vb) return 1;
-    return 0;
+    uint64_t ka = ternary_compare_key(a);
+    uint64_t kb = ternary_compare_key(b);
+    return (ka > kb) - (ka < kb);
 }
 
 static inline int __ternary_cmp_t64(t64_t a, t64_t b) {
-    int64_t va = ternary_decode_u128(a, 64);
-    int64_t vb = ternary_decode_u128(b, 64);
-    if (va < vb) return -1;
-    if (va > vb) return 1;
-    return 0;
+    unsigned __int128 ka = ternary_compare_key_u128(a);
+    unsigned __int128 kb = ternary_compare_key_u128(b);
+    return (ka > kb) - (ka < kb);
 }
 
 /* Extended helper declarations that mirror the runtime implementations. */
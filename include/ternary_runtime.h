@@ -1,6 +1,7 @@
 #ifndef TERNARY_RUNTIME_H
 #define TERNARY_RUNTIME_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdarg.h>
 
@@ -149,6 +150,21 @@ int __ternary_cmp_t64(t64_t a, t64_t b);
 t64_t __ternary_bt_str_t64(const char *s);
 
 #if defined(__BITINT_MAXWIDTH__) && __BITINT_MAXWIDTH__ >= 256 && !defined(__cplusplus)
+t128_t __ternary_select_t128(TERNARY_COND_T cond, t128_t true_val, t128_t false_val);
+int __ternary_cmp_t128(t128_t a, t128_t b);
+t128_t __ternary_not_t128(t128_t a);
+t128_t __ternary_and_t128(t128_t a, t128_t b);
+t128_t __ternary_or_t128(t128_t a, t128_t b);
+t128_t __ternary_add_t128(t128_t a, t128_t b);
+t128_t __ternary_sub_t128(t128_t a, t128_t b);
+t128_t __ternary_neg_t128(t128_t a);
+t128_t __ternary_mul_t128(t128_t a, t128_t b);
+t128_t __ternary_div_t128(t128_t a, t128_t b);
+t128_t __ternary_mod_t128(t128_t a, t128_t b);
+t128_t __ternary_shl_t128(t128_t a, int shift);
+t128_t __ternary_shr_t128(t128_t a, int shift);
+t128_t __ternary_rol_t128(t128_t a, int shift);
+t128_t __ternary_ror_t128(t128_t a, int shift);
 t128_t __ternary_tmin_t128(t128_t a, t128_t b);
 t128_t __ternary_tmax_t128(t128_t a, t128_t b);
 t128_t __ternary_tmaj_t128(t128_t a, t128_t b, t128_t c);
@@ -184,6 +200,38 @@ void __ternary_store_t32(void *addr, t32_t value);
 t64_t __ternary_load_t64(const void *addr);
 void __ternary_store_t64(void *addr, t64_t value);
 
+/* Bulk array helpers: element-wise over n values; dst may be the same array as an input. */
+void __ternary_add_t32_n(t32_t *dst, const t32_t *a, const t32_t *b, size_t n);
+void __ternary_sub_t32_n(t32_t *dst, const t32_t *a, const t32_t *b, size_t n);
+void __ternary_mul_t32_n(t32_t *dst, const t32_t *a, const t32_t *b, size_t n);
+void __ternary_neg_t32_n(t32_t *dst, const t32_t *a, size_t n);
+void __ternary_tmin_t32_n(t32_t *dst, const t32_t *a, const t32_t *b, size_t n);
+void __ternary_tmax_t32_n(t32_t *dst, const t32_t *a, const t32_t *b, size_t n);
+void __ternary_txor_t32_n(t32_t *dst, const t32_t *a, const t32_t *b, size_t n);
+void __ternary_tequiv_t32_n(t32_t *dst, const t32_t *a, const t32_t *b, size_t n);
+void __ternary_tmux_t32_n(t32_t *dst, const t32_t *sel, const t32_t *neg, const t32_t *zero,
+                          const t32_t *pos, size_t n);
+void __ternary_tmuladd_t32_n(t32_t *dst, const t32_t *a, const t32_t *b, const t32_t *c,
+                             size_t n);
+void __ternary_cmp_t32_n(int *dst, const t32_t *a, const t32_t *b, size_t n);
+void __ternary_select_t32_n(t32_t *dst, const TERNARY_COND_T *cond, const t32_t *true_val,
+                            const t32_t *false_val, size_t n);
+void __ternary_add_t64_n(t64_t *dst, const t64_t *a, const t64_t *b, size_t n);
+void __ternary_sub_t64_n(t64_t *dst, const t64_t *a, const t64_t *b, size_t n);
+void __ternary_mul_t64_n(t64_t *dst, const t64_t *a, const t64_t *b, size_t n);
+void __ternary_neg_t64_n(t64_t *dst, const t64_t *a, size_t n);
+void __ternary_tmin_t64_n(t64_t *dst, const t64_t *a, const t64_t *b, size_t n);
+void __ternary_tmax_t64_n(t64_t *dst, const t64_t *a, const t64_t *b, size_t n);
+void __ternary_txor_t64_n(t64_t *dst, const t64_t *a, const t64_t *b, size_t n);
+void __ternary_tequiv_t64_n(t64_t *dst, const t64_t *a, const t64_t *b, size_t n);
+void __ternary_tmux_t64_n(t64_t *dst, const t64_t *sel, const t64_t *neg, const t64_t *zero,
+                          const t64_t *pos, size_t n);
+void __ternary_tmuladd_t64_n(t64_t *dst, const t64_t *a, const t64_t *b, const t64_t *c,
+                             size_t n);
+void __ternary_cmp_t64_n(int *dst, const t64_t *a, const t64_t *b, size_t n);
+void __ternary_select_t64_n(t64_t *dst, const TERNARY_COND_T *cond, const t64_t *true_val,
+                            const t64_t *false_val, size_t n);
+
 /* Vector operations - SIMD accelerated ternary computations */
 tv32_t __ternary_add_tv32(tv32_t a, tv32_t b);
 tv32_t __ternary_sub_tv32(tv32_t a, tv32_t b);
@@ -4,52 +4,295 @@
  * This is a portable skeleton; replace with ISA-specific code as needed.
  */
 
+/* With TERNARY_RUNTIME_DISPATCH (the CMake library build), helpers that have
+ * ISA-specific variants keep their portable body here under a _generic name
+ * and ternary_runtime_opt.c exports the dispatched symbol.
+ */
+#ifdef TERNARY_RUNTIME_DISPATCH
+#include "ternary_runtime_opt.h"
+#define TERNARY_DISPATCHED(NAME) NAME##_generic
+#else
+#define TERNARY_DISPATCHED(NAME) NAME
+#endif
+
 static unsigned ternary_trit_to_bits(int trit)
 {
     return (trit < 0) ? 0U : (trit == 0 ? 1U : 2U);
 }
 
-static int ternary_bits_to_trit(unsigned bits)
+/* Packed-domain add/sub.
+ * The 00/01/10 codes are the plain base-3 digits of value + (3^n - 1) / 2,
+ * so a balanced add is a base-3 add on 2-bit fields plus a bias correction.
+ * Each field is pre-biased by one so a digit sum >= 3 carries out of the
+ * field; fields that did not carry then give the extra one back.
+ */
+#define TERNARY_TRIT_LSB_U64 0x5555555555555555ULL
+#define TERNARY_TRIT_LSB_U128 \
+    (((unsigned __int128)TERNARY_TRIT_LSB_U64 << 64) | TERNARY_TRIT_LSB_U64)
+
+static inline uint64_t ternary_digits_u64(uint64_t packed)
 {
-    if (bits == 0U)
-        return -1;
-    if (bits == 1U)
-        return 0;
-    return 1;
+    /* Reserved 11 codes decode as +1; fold them to 10. */
+    return packed & ~(packed & (packed >> 1) & TERNARY_TRIT_LSB_U64);
 }
 
-static int64_t ternary_decode(uint64_t packed, unsigned trit_count)
+static inline uint64_t ternary_digit_add_u64(uint64_t a, uint64_t b)
 {
-    int64_t value = 0;
-    int64_t pow3 = 1;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        unsigned bits = (unsigned)((packed >> (2U * i)) & 0x3U);
-        int trit = ternary_bits_to_trit(bits);
-        value += (int64_t)trit * pow3;
-        pow3 *= 3;
+    uint64_t biased = a + TERNARY_TRIT_LSB_U64;
+    uint64_t sum = biased + b;
+    uint64_t carry = ((biased ^ b ^ sum) >> 2) & TERNARY_TRIT_LSB_U64;
+    carry |= (uint64_t)(sum < biased) << 62;
+    return sum - (TERNARY_TRIT_LSB_U64 & ~carry);
+}
+
+static inline uint64_t ternary_add_u64(uint64_t a, uint64_t b)
+{
+    uint64_t sum = ternary_digit_add_u64(ternary_digits_u64(a), ternary_digits_u64(b));
+    /* Drop the second bias: adding 3^n - bias is subtracting it mod 3^n. */
+    return ternary_digit_add_u64(sum, TERNARY_TRIT_LSB_U64 + 1U);
+}
+
+static inline uint64_t ternary_neg_u64(uint64_t packed)
+{
+    return (TERNARY_TRIT_LSB_U64 << 1) - ternary_digits_u64(packed);
+}
+
+static inline uint64_t ternary_sub_u64(uint64_t a, uint64_t b)
+{
+    return ternary_add_u64(a, ternary_neg_u64(b));
+}
+
+/* Word-wide tritwise logic.
+ * A packed word splits into a +1 mask (the high bit of each field) and a -1
+ * mask (fields that are 00), both kept at the field's low bit. min/max,
+ * majority and implication are plain boolean ops on those masks; the result
+ * is packed back as 10 for +1, 01 for 0 and 00 for -1. Reserved 11 codes
+ * read as +1, as they do when decoding.
+ */
+#define DEFINE_TERNARY_LOGIC_OPS(SUFFIX, WORD_T, LSB) \
+    static inline WORD_T ternary_plus_mask_##SUFFIX(WORD_T packed) \
+    { \
+        return (packed >> 1) & (LSB); \
+    } \
+    static inline WORD_T ternary_minus_mask_##SUFFIX(WORD_T packed) \
+    { \
+        return ~(packed | (packed >> 1)) & (LSB); \
+    } \
+    static inline WORD_T ternary_from_masks_##SUFFIX(WORD_T plus, WORD_T minus) \
+    { \
+        return (plus << 1) | ((LSB) & ~(plus | minus)); \
+    } \
+    static inline WORD_T ternary_tmin_##SUFFIX(WORD_T a, WORD_T b) \
+    { \
+        return ternary_from_masks_##SUFFIX( \
+            ternary_plus_mask_##SUFFIX(a) & ternary_plus_mask_##SUFFIX(b), \
+            ternary_minus_mask_##SUFFIX(a) | ternary_minus_mask_##SUFFIX(b)); \
+    } \
+    static inline WORD_T ternary_tmax_##SUFFIX(WORD_T a, WORD_T b) \
+    { \
+        return ternary_from_masks_##SUFFIX( \
+            ternary_plus_mask_##SUFFIX(a) | ternary_plus_mask_##SUFFIX(b), \
+            ternary_minus_mask_##SUFFIX(a) & ternary_minus_mask_##SUFFIX(b)); \
+    } \
+    /* (a + b) mod 3 per trit, balanced: +1 from 0+1, 1+0, -1-1; -1 mirrored. */ \
+    static inline WORD_T ternary_xor_##SUFFIX(WORD_T a, WORD_T b) \
+    { \
+        WORD_T pa = ternary_plus_mask_##SUFFIX(a); \
+        WORD_T ma = ternary_minus_mask_##SUFFIX(a); \
+        WORD_T pb = ternary_plus_mask_##SUFFIX(b); \
+        WORD_T mb = ternary_minus_mask_##SUFFIX(b); \
+        WORD_T za = (LSB) & ~(pa | ma); \
+        WORD_T zb = (LSB) & ~(pb | mb); \
+        return ternary_from_masks_##SUFFIX((pa & zb) | (za & pb) | (ma & mb), \
+                                           (ma & zb) | (za & mb) | (pa & pb)); \
+    } \
+    static inline WORD_T ternary_tnot_##SUFFIX(WORD_T packed) \
+    { \
+        return ternary_from_masks_##SUFFIX(ternary_minus_mask_##SUFFIX(packed), \
+                                           ternary_plus_mask_##SUFFIX(packed)); \
+    } \
+    static inline WORD_T ternary_tmaj_##SUFFIX(WORD_T a, WORD_T b, WORD_T c) \
+    { \
+        WORD_T pa = ternary_plus_mask_##SUFFIX(a); \
+        WORD_T pb = ternary_plus_mask_##SUFFIX(b); \
+        WORD_T pc = ternary_plus_mask_##SUFFIX(c); \
+        WORD_T ma = ternary_minus_mask_##SUFFIX(a); \
+        WORD_T mb = ternary_minus_mask_##SUFFIX(b); \
+        WORD_T mc = ternary_minus_mask_##SUFFIX(c); \
+        return ternary_from_masks_##SUFFIX((pa & pb) | (pa & pc) | (pb & pc), \
+                                           (ma & mb) | (ma & mc) | (mb & mc)); \
+    } \
+    /* -1 -> c is +1; otherwise the result is c. */ \
+    static inline WORD_T ternary_tlimp_##SUFFIX(WORD_T antecedent, WORD_T consequent) \
+    { \
+        WORD_T ma = ternary_minus_mask_##SUFFIX(antecedent); \
+        return ternary_from_masks_##SUFFIX(ma | ternary_plus_mask_##SUFFIX(consequent), \
+                                           ~ma & ternary_minus_mask_##SUFFIX(consequent)); \
+    } \
+    /* Reserved 11 codes become 01 (zero). */ \
+    static inline WORD_T ternary_tnormalize_##SUFFIX(WORD_T packed) \
+    { \
+        return packed & ~((packed & (packed >> 1) & (LSB)) << 1); \
     }
-    return value;
+
+DEFINE_TERNARY_LOGIC_OPS(u64, uint64_t, TERNARY_TRIT_LSB_U64)
+DEFINE_TERNARY_LOGIC_OPS(u128, unsigned __int128, TERNARY_TRIT_LSB_U128)
+
+/* Net trit sum: count(+1) - count(-1), one popcount per mask. */
+static int ternary_tnet_u64(uint64_t packed)
+{
+    return __builtin_popcountll(ternary_plus_mask_u64(packed)) -
+           __builtin_popcountll(ternary_minus_mask_u64(packed));
 }
 
-static uint64_t ternary_encode(int64_t value, unsigned trit_count)
+static int ternary_popcount_u128(unsigned __int128 mask)
 {
-    uint64_t packed = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int64_t rem = value % 3;
-        value /= 3;
-
-        if (rem == 2) {
-            rem = -1;
-            value += 1;
-        } else if (rem == -2) {
-            rem = 1;
-            value -= 1;
-        }
+    return __builtin_popcountll((uint64_t)mask) + __builtin_popcountll((uint64_t)(mask >> 64));
+}
+
+static int ternary_tnet_u128(unsigned __int128 packed)
+{
+    return ternary_popcount_u128(ternary_plus_mask_u128(packed)) -
+           ternary_popcount_u128(ternary_minus_mask_u128(packed));
+}
+
+/* Sign of the most significant non-zero trit. The +1 and -1 masks are
+ * disjoint, so whichever is larger as an unsigned word owns that trit. */
+static int ternary_sign_u64(uint64_t packed)
+{
+    uint64_t plus = ternary_plus_mask_u64(packed);
+    uint64_t minus = ternary_minus_mask_u64(packed);
+    return (plus > minus) - (plus < minus);
+}
+
+static int ternary_sign_u128(unsigned __int128 packed)
+{
+    unsigned __int128 plus = ternary_plus_mask_u128(packed);
+    unsigned __int128 minus = ternary_minus_mask_u128(packed);
+    return (plus > minus) - (plus < minus);
+}
+
+/* Trit shifts and rotates on whole words; trit_count must fill the word.
+ * A trit shift is a 2k-bit shift: shl fills the vacated low trits with the
+ * zero code 01 and shr repeats the top trit into the vacated high trits.
+ * Rotates are plain 2k-bit rotates. Counts are reduced modulo trit_count and
+ * reserved 11 codes come out as 10, as with the per-trit rebuild.
+ */
+#define DEFINE_TERNARY_SHIFT_OPS(SUFFIX, WORD_T, LSB, DIGITS) \
+    static WORD_T ternary_shift_left_##SUFFIX(WORD_T packed, unsigned trit_count, unsigned shift) \
+    { \
+        WORD_T digits = DIGITS(packed); \
+        unsigned bits = 2U * (shift % trit_count); \
+        if (bits == 0) \
+            return digits; \
+        return (digits << bits) | ((LSB) >> (2U * trit_count - bits)); \
+    } \
+    static WORD_T ternary_shift_right_##SUFFIX(WORD_T packed, unsigned trit_count, unsigned shift) \
+    { \
+        WORD_T digits = DIGITS(packed); \
+        unsigned bits = 2U * (shift % trit_count); \
+        if (bits == 0) \
+            return digits; \
+        WORD_T top = digits >> (2U * trit_count - 2U); \
+        return (digits >> bits) | (((LSB) << (2U * trit_count - bits)) * top); \
+    } \
+    static WORD_T ternary_rotate_left_##SUFFIX(WORD_T packed, unsigned trit_count, unsigned shift) \
+    { \
+        WORD_T digits = DIGITS(packed); \
+        unsigned bits = 2U * (shift % trit_count); \
+        if (bits == 0) \
+            return digits; \
+        return (digits << bits) | (digits >> (2U * trit_count - bits)); \
+    } \
+    static WORD_T ternary_rotate_right_##SUFFIX(WORD_T packed, unsigned trit_count, unsigned shift) \
+    { \
+        WORD_T digits = DIGITS(packed); \
+        unsigned bits = 2U * (shift % trit_count); \
+        if (bits == 0) \
+            return digits; \
+        return (digits >> bits) | (digits << (2U * trit_count - bits)); \
+    }
+
+DEFINE_TERNARY_SHIFT_OPS(u64, uint64_t, TERNARY_TRIT_LSB_U64, ternary_digits_u64)
+
+/* 3^32: one t32 word, and the split point for wider values. */
+#define TERNARY_POW3_32 INT64_C(1853020188851841)
 
-        unsigned bits = ternary_trit_to_bits((int)rem);
-        packed |= ((uint64_t)bits) << (2U * i);
+/* Scalar <-> packed conversion for up to 32 trits.
+ * Decoding folds the base-3 digit fields together pairwise with constant
+ * multiplies (2 -> 4 -> 8 -> 16 -> 32 trits) and removes the bias once.
+ * Encoding biases the value into [0, 3^n), splits it into 8-trit chunks with
+ * constant divisors and packs each chunk from a 4-trit lookup table.
+ */
+static const uint8_t ternary_pack4_table[81] = {
+    0x00, 0x01, 0x02, 0x04, 0x05, 0x06, 0x08, 0x09, 0x0a,
+    0x10, 0x11, 0x12, 0x14, 0x15, 0x16, 0x18, 0x19, 0x1a,
+    0x20, 0x21, 0x22, 0x24, 0x25, 0x26, 0x28, 0x29, 0x2a,
+    0x40, 0x41, 0x42, 0x44, 0x45, 0x46, 0x48, 0x49, 0x4a,
+    0x50, 0x51, 0x52, 0x54, 0x55, 0x56, 0x58, 0x59, 0x5a,
+    0x60, 0x61, 0x62, 0x64, 0x65, 0x66, 0x68, 0x69, 0x6a,
+    0x80, 0x81, 0x82, 0x84, 0x85, 0x86, 0x88, 0x89, 0x8a,
+    0x90, 0x91, 0x92, 0x94, 0x95, 0x96, 0x98, 0x99, 0x9a,
+    0xa0, 0xa1, 0xa2, 0xa4, 0xa5, 0xa6, 0xa8, 0xa9, 0xaa
+};
+
+static int64_t ternary_pow3(unsigned n)
+{
+    uint64_t result = 1;
+    uint64_t base = 3;
+    for (; n != 0; n >>= 1) {
+        if (n & 1U)
+            result *= base;
+        base *= base;
     }
-    return packed;
+    return (int64_t)result;
+}
+
+static int64_t ternary_decode(uint64_t packed, unsigned trit_count)
+{
+    uint64_t x = ternary_digits_u64(packed);
+    if (trit_count < 32)
+        x &= (UINT64_C(1) << (2U * trit_count)) - 1U;
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL) * 3U;
+    x = (x & 0x0F0F0F0F0F0F0F0FULL) + ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) * 9U;
+    x = (x & 0x00FF00FF00FF00FFULL) + ((x >> 8) & 0x00FF00FF00FF00FFULL) * 81U;
+    x = (x & 0x0000FFFF0000FFFFULL) + ((x >> 16) & 0x0000FFFF0000FFFFULL) * 6561U;
+    x = (x & 0xFFFFFFFFULL) + (x >> 32) * 43046721U;
+    return (int64_t)x - (ternary_pow3(trit_count) - 1) / 2;
+}
+
+static uint64_t ternary_pack8(unsigned digits)
+{
+    return (uint64_t)ternary_pack4_table[digits % 81U] |
+           (uint64_t)ternary_pack4_table[digits / 81U] << 8;
+}
+
+static uint64_t ternary_encode(int64_t value, unsigned trit_count)
+{
+    if (trit_count == 0)
+        return 0;
+    int64_t modulus = ternary_pow3(trit_count);
+    int64_t biased = value % modulus + (modulus - 1) / 2;
+    if (biased < 0)
+        biased += modulus;
+    else if (biased >= modulus)
+        biased -= modulus;
+
+    uint64_t digits = (uint64_t)biased;
+    uint64_t packed = ternary_pack8((unsigned)(digits % 6561U));
+    digits /= 6561U;
+    packed |= ternary_pack8((unsigned)(digits % 6561U)) << 16;
+    digits /= 6561U;
+    packed |= ternary_pack8((unsigned)(digits % 6561U)) << 32;
+    digits /= 6561U;
+    return packed | ternary_pack8((unsigned)digits) << 48;
+}
+
+static uint64_t ternary_mul_u64(uint64_t a, uint64_t b)
+{
+    /* The product needs ~100 bits; only its residue mod 3^32 survives. */
+    __int128 product = (__int128)ternary_decode(a, 32) * ternary_decode(b, 32);
+    return ternary_encode((int64_t)(product % TERNARY_POW3_32), 32);
 }
 
 static int ternary_parse_bt_str(const char *s, int64_t *out)
@@ -101,16 +344,6 @@ static int ternary_parse_bt_str(const char *s, int64_t *out)
     return 1;
 }
 
-static int ternary_trit_min(int a, int b)
-{
-    return (a < b) ? a : b;
-}
-
-static int ternary_trit_max(int a, int b)
-{
-    return (a > b) ? a : b;
-}
-
 static int ternary_trit_xor(int a, int b)
 {
     int sum = a + b;
@@ -120,12 +353,6 @@ static int ternary_trit_xor(int a, int b)
     return -1;
 }
 
-static int ternary_get_trit(uint64_t packed, unsigned idx)
-{
-    unsigned bits = (unsigned)((packed >> (2U * idx)) & 0x3U);
-    return ternary_bits_to_trit(bits);
-}
-
 static uint64_t ternary_set_trit(uint64_t packed, unsigned idx, int trit)
 {
     uint64_t mask = 0x3ULL << (2U * idx);
@@ -133,82 +360,22 @@ static uint64_t ternary_set_trit(uint64_t packed, unsigned idx, int trit)
     return (packed & ~mask) | bits;
 }
 
-static uint64_t ternary_tritwise_op(uint64_t a, uint64_t b, unsigned trit_count, int op)
-{
-    uint64_t out = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int ta = ternary_get_trit(a, i);
-        int tb = ternary_get_trit(b, i);
-        int trit = 0;
-        if (op == 0)
-            trit = ternary_trit_min(ta, tb);
-        else if (op == 1)
-            trit = ternary_trit_max(ta, tb);
-        else
-            trit = ternary_trit_xor(ta, tb);
-        out = ternary_set_trit(out, i, trit);
-    }
-    return out;
-}
-
-static int ternary_get_trit_u128(unsigned __int128 packed, unsigned idx);
 static unsigned __int128 ternary_set_trit_u128(unsigned __int128 packed, unsigned idx, int trit);
-static int64_t ternary_decode_u128(unsigned __int128 packed, unsigned trit_count);
-static unsigned __int128 ternary_encode_u128(int64_t value, unsigned trit_count);
-static int ternary_signjmp_u128(unsigned __int128 packed, unsigned trit_count,
-                                int neg_target, int zero_target, int pos_target);
-
-static int ternary_trit_majority(int a, int b, int c)
-{
-    if (a == b || a == c)
-        return a;
-    if (b == c)
-        return b;
-    return 0;
-}
-
-static int ternary_trit_implication(int antecedent, int consequent)
-{
-    if (antecedent == -1)
-        return 1;
-    if (antecedent == 0) {
-        if (consequent == -1)
-            return -1;
-        if (consequent == 0)
-            return 0;
-        return 1;
-    }
-    return consequent;
-}
-
-static uint64_t ternary_not_u64(uint64_t packed, unsigned trit_count)
-{
-    uint64_t out = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = ternary_get_trit(packed, i);
-        int inverted = (trit == 0) ? 0 : -trit;
-        out = ternary_set_trit(out, i, inverted);
-    }
-    return out;
-}
-
-static int64_t ternary_muladd_scalar(int64_t a, int64_t b, int64_t c)
-{
-    return a * b + c;
-}
+static __int128 ternary_decode_u128(unsigned __int128 packed, unsigned trit_count);
+static unsigned __int128 ternary_encode_u128(__int128 value, unsigned trit_count);
 
 static uint64_t ternary_muladd_u64(uint64_t a, uint64_t b, uint64_t c, unsigned trit_count)
 {
-    int64_t va = ternary_decode(a, trit_count);
-    int64_t vb = ternary_decode(b, trit_count);
+    __int128 va = ternary_decode(a, trit_count);
+    __int128 vb = ternary_decode(b, trit_count);
     int64_t vc = ternary_decode(c, trit_count);
-    return ternary_encode(ternary_muladd_scalar(va, vb, vc), trit_count);
+    return ternary_encode((int64_t)((va * vb) % TERNARY_POW3_32) + vc, trit_count);
 }
 
 static uint64_t ternary_round_u64(uint64_t packed, unsigned trit_count, unsigned drop)
 {
     if (drop >= trit_count)
-        return 0;
+        return ternary_encode(0, trit_count);
     int64_t value = ternary_decode(packed, trit_count);
     int64_t divisor = 1;
     for (unsigned i = 0; i < drop; ++i)
@@ -216,71 +383,35 @@ static uint64_t ternary_round_u64(uint64_t packed, unsigned trit_count, unsigned
     return ternary_encode(value / divisor, trit_count);
 }
 
-static unsigned __int128 ternary_not_u128(unsigned __int128 packed, unsigned trit_count)
-{
-    unsigned __int128 out = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = ternary_get_trit_u128(packed, i);
-        int inverted = (trit == 0) ? 0 : -trit;
-        out = ternary_set_trit_u128(out, i, inverted);
-    }
-    return out;
-}
+static __int128 ternary_mulmod_t64(__int128 a, __int128 b);
 
 static unsigned __int128 ternary_muladd_u128(unsigned __int128 a, unsigned __int128 b,
                                              unsigned __int128 c, unsigned trit_count)
 {
-    int64_t va = ternary_decode_u128(a, trit_count);
-    int64_t vb = ternary_decode_u128(b, trit_count);
-    int64_t vc = ternary_decode_u128(c, trit_count);
-    return ternary_encode_u128(ternary_muladd_scalar(va, vb, vc), trit_count);
+    __int128 va = ternary_decode_u128(a, trit_count);
+    __int128 vb = ternary_decode_u128(b, trit_count);
+    __int128 vc = ternary_decode_u128(c, trit_count);
+    return ternary_encode_u128(ternary_mulmod_t64(va, vb) + vc, trit_count);
 }
 
 static unsigned __int128 ternary_round_u128(unsigned __int128 packed, unsigned trit_count,
                                             unsigned drop)
 {
     if (drop >= trit_count)
-        return 0;
-    int64_t value = ternary_decode_u128(packed, trit_count);
-    int64_t divisor = 1;
+        return ternary_encode_u128(0, trit_count);
+    __int128 value = ternary_decode_u128(packed, trit_count);
+    __int128 divisor = 1;
     for (unsigned i = 0; i < drop; ++i)
         divisor *= 3;
     return ternary_encode_u128(value / divisor, trit_count);
 }
 
-static unsigned __int128 ternary_normalize_u128(unsigned __int128 packed, unsigned trit_count)
-{
-    unsigned __int128 out = packed;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        unsigned bits = (unsigned)((packed >> (2U * i)) & 0x3U);
-        if (bits == 0x3U) {
-            unsigned __int128 mask = (unsigned __int128)0x3U << (2U * i);
-            out &= ~mask;
-            out |= (unsigned __int128)0x1U << (2U * i);
-        }
-    }
-    return out;
-}
-
 static unsigned __int128 ternary_tbias_u128(unsigned __int128 packed, unsigned trit_count, int64_t bias)
 {
-    int64_t value = ternary_decode_u128(packed, trit_count);
+    __int128 value = ternary_decode_u128(packed, trit_count);
     return ternary_encode_u128(value + bias, trit_count);
 }
 
-static uint64_t ternary_normalize_u64(uint64_t packed, unsigned trit_count)
-{
-    uint64_t out = packed;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        unsigned bits = (unsigned)((packed >> (2U * i)) & 0x3U);
-        if (bits == 0x3U) {
-            out &= ~(0x3ULL << (2U * i));
-            out |= (0x1ULL << (2U * i));
-        }
-    }
-    return out;
-}
-
 static uint64_t ternary_tbias_u64(uint64_t packed, unsigned trit_count, int64_t bias)
 {
     int64_t value = ternary_decode(packed, trit_count);
@@ -296,27 +427,6 @@ static int ternary_branch_target(TERNARY_COND_T cond, int neg_target, int zero_t
     return zero_target;
 }
 
-static int ternary_signjmp_u64(uint64_t packed, unsigned trit_count,
-                               int neg_target, int zero_target, int pos_target)
-{
-    int64_t value = ternary_decode(packed, trit_count);
-    if (value < 0)
-        return neg_target;
-    if (value > 0)
-        return pos_target;
-    return zero_target;
-}
-
-static int ternary_signjmp_u128(unsigned __int128 packed, unsigned trit_count,
-                                int neg_target, int zero_target, int pos_target)
-{
-    int64_t value = ternary_decode_u128(packed, trit_count);
-    if (value < 0)
-        return neg_target;
-    if (value > 0)
-        return pos_target;
-    return zero_target;
-}
 
 static int ternary_quantize_scalar(float value, float threshold)
 {
@@ -336,29 +446,6 @@ static int ternary_quantize_scalar_d(double value, double threshold)
     return 0;
 }
 
-static uint64_t ternary_majority_u64(uint64_t a, uint64_t b, uint64_t c, unsigned trit_count)
-{
-    uint64_t out = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = ternary_trit_majority(ternary_get_trit(a, i),
-                                          ternary_get_trit(b, i),
-                                          ternary_get_trit(c, i));
-        out = ternary_set_trit(out, i, trit);
-    }
-    return out;
-}
-
-static uint64_t ternary_implication_u64(uint64_t a, uint64_t b, unsigned trit_count)
-{
-    uint64_t out = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = ternary_trit_implication(ternary_get_trit(a, i),
-                                             ternary_get_trit(b, i));
-        out = ternary_set_trit(out, i, trit);
-    }
-    return out;
-}
-
 static uint64_t ternary_quantize_vector(float value, float threshold, unsigned trit_count)
 {
     int trit = ternary_quantize_scalar(value, threshold);
@@ -370,102 +457,56 @@ static uint64_t ternary_quantize_vector(float value, float threshold, unsigned t
     return result;
 }
 
-static int ternary_sign_u64(uint64_t packed, unsigned trit_count)
+/* A single trit in the low position of an otherwise-zero word. */
+static t32_t ternary_encode_trit32(int trit)
 {
-    for (int i = (int)trit_count - 1; i >= 0; --i) {
-        int trit = ternary_get_trit(packed, (unsigned)i);
-        if (trit != 0)
-            return trit;
-    }
-    return 0;
+    return (t32_t)(TERNARY_TRIT_LSB_U64 + (uint64_t)(int64_t)trit);
 }
 
-static int ternary_sign_u128(unsigned __int128 packed, unsigned trit_count)
+static t64_t ternary_encode_trit64(int trit)
 {
-    for (int i = (int)trit_count - 1; i >= 0; --i) {
-        int trit = ternary_get_trit_u128(packed, (unsigned)i);
-        if (trit != 0)
-            return trit;
-    }
-    return 0;
+    return (t64_t)(TERNARY_TRIT_LSB_U128 + (unsigned __int128)(__int128)trit);
 }
 
-static t32_t ternary_encode_trit32(int trit)
+/* Sign-level equivalence: +1 for equal nonzero signs, -1 for opposite, else 0. */
+static int ternary_equiv_sign(int sign_a, int sign_b)
 {
-    return (t32_t)ternary_encode(trit, 32);
+    return sign_a * sign_b;
 }
 
-static t64_t ternary_encode_trit64(int trit)
+/* Sign-level xor: -1 for equal nonzero signs, +1 when exactly one is zero. */
+static int ternary_xor_sign(int sign_a, int sign_b)
 {
-    return (t64_t)ternary_encode_u128(trit, 64);
+    return ((sign_a & 1) ^ (sign_b & 1)) - (sign_a * sign_b > 0);
 }
 
 static t32_t ternary_tequiv_t32(t32_t a, t32_t b)
 {
-    int sign_a = ternary_sign_u64((uint64_t)a, 32);
-    int sign_b = ternary_sign_u64((uint64_t)b, 32);
-    int trit = 0;
-    if (sign_a == 0 || sign_b == 0)
-        trit = 0;
-    else if (sign_a == sign_b)
-        trit = 1;
-    else
-        trit = -1;
-    return ternary_encode_trit32(trit);
+    return ternary_encode_trit32(ternary_equiv_sign(ternary_sign_u64((uint64_t)a),
+                                                    ternary_sign_u64((uint64_t)b)));
 }
 
 static t64_t ternary_tequiv_t64(t64_t a, t64_t b)
 {
-    int sign_a = ternary_sign_u128((unsigned __int128)a, 64);
-    int sign_b = ternary_sign_u128((unsigned __int128)b, 64);
-    int trit = 0;
-    if (sign_a == 0 || sign_b == 0)
-        trit = 0;
-    else if (sign_a == sign_b)
-        trit = 1;
-    else
-        trit = -1;
-    return ternary_encode_trit64(trit);
+    return ternary_encode_trit64(ternary_equiv_sign(ternary_sign_u128((unsigned __int128)a),
+                                                    ternary_sign_u128((unsigned __int128)b)));
 }
 
-
 static t32_t ternary_txor_t32(t32_t a, t32_t b)
 {
-    int sign_a = ternary_sign_u64((uint64_t)a, 32);
-    int sign_b = ternary_sign_u64((uint64_t)b, 32);
-    int trit = 0;
-    if (sign_a == sign_b && sign_a != 0)
-        trit = -1;
-    else if (sign_b == 0 && sign_a != 0)
-        trit = 1;
-    else if (sign_a == 0 && sign_b != 0)
-        trit = 1;
-    else
-        trit = 0;
-    return ternary_encode_trit32(trit);
+    return ternary_encode_trit32(ternary_xor_sign(ternary_sign_u64((uint64_t)a),
+                                                  ternary_sign_u64((uint64_t)b)));
 }
 
 static t64_t ternary_txor_t64(t64_t a, t64_t b)
 {
-    int sign_a = ternary_sign_u128((unsigned __int128)a, 64);
-    int sign_b = ternary_sign_u128((unsigned __int128)b, 64);
-    int trit = 0;
-    if (sign_a == sign_b && sign_a != 0)
-        trit = -1;
-    else if (sign_b == 0 && sign_a != 0)
-        trit = 1;
-    else if (sign_a == 0 && sign_b != 0)
-        trit = 1;
-    else
-        trit = 0;
-    return ternary_encode_trit64(trit);
+    return ternary_encode_trit64(ternary_xor_sign(ternary_sign_u128((unsigned __int128)a),
+                                                  ternary_sign_u128((unsigned __int128)b)));
 }
 
-
-
 static t32_t ternary_tmux_u32(t32_t sel, t32_t neg, t32_t zero, t32_t pos)
 {
-    int64_t cond = ternary_decode((uint64_t)sel, 32);
+    int cond = ternary_sign_u64((uint64_t)sel);
     if (cond < 0)
         return neg;
     if (cond > 0)
@@ -475,7 +516,7 @@ static t32_t ternary_tmux_u32(t32_t sel, t32_t neg, t32_t zero, t32_t pos)
 
 static t64_t ternary_tmux_u64(t64_t sel, t64_t neg, t64_t zero, t64_t pos)
 {
-    int64_t cond = ternary_decode_u128((unsigned __int128)sel, 64);
+    int cond = ternary_sign_u128((unsigned __int128)sel);
     if (cond < 0)
         return neg;
     if (cond > 0)
@@ -483,31 +524,6 @@ static t64_t ternary_tmux_u64(t64_t sel, t64_t neg, t64_t zero, t64_t pos)
     return zero;
 }
 
-static unsigned __int128 ternary_majority_u128(unsigned __int128 a, unsigned __int128 b,
-                                               unsigned __int128 c, unsigned trit_count)
-{
-    unsigned __int128 out = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = ternary_trit_majority(ternary_get_trit_u128(a, i),
-                                          ternary_get_trit_u128(b, i),
-                                          ternary_get_trit_u128(c, i));
-        out = ternary_set_trit_u128(out, i, trit);
-    }
-    return out;
-}
-
-static unsigned __int128 ternary_implication_u128(unsigned __int128 a, unsigned __int128 b,
-                                                  unsigned trit_count)
-{
-    unsigned __int128 out = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = ternary_trit_implication(ternary_get_trit_u128(a, i),
-                                             ternary_get_trit_u128(b, i));
-        out = ternary_set_trit_u128(out, i, trit);
-    }
-    return out;
-}
-
 static unsigned __int128 ternary_quantize_vector_d(double value, double threshold,
                                                    unsigned trit_count)
 {
@@ -521,12 +537,11 @@ static unsigned __int128 ternary_quantize_vector_d(double value, double threshol
 }
 
 #if defined(__BITINT_MAXWIDTH__) && __BITINT_MAXWIDTH__ >= 256 && !defined(__cplusplus)
-static int ternary_get_trit_t128(t128_t packed, unsigned idx)
-{
-    t128_t mask = (t128_t)0x3U << (2U * idx);
-    t128_t bits = (packed & mask) >> (2U * idx);
-    return ternary_bits_to_trit((unsigned)bits);
-}
+#define TERNARY_TRIT_LSB_T128 \
+    (((t128_t)TERNARY_TRIT_LSB_U64 << 192) | ((t128_t)TERNARY_TRIT_LSB_U64 << 128) | \
+     ((t128_t)TERNARY_TRIT_LSB_U64 << 64) | (t128_t)TERNARY_TRIT_LSB_U64)
+
+DEFINE_TERNARY_LOGIC_OPS(t128, t128_t, TERNARY_TRIT_LSB_T128)
 
 static t128_t ternary_set_trit_t128(t128_t packed, unsigned idx, int trit)
 {
@@ -535,292 +550,217 @@ static t128_t ternary_set_trit_t128(t128_t packed, unsigned idx, int trit)
     return (packed & ~mask) | bits;
 }
 
-static int64_t ternary_decode_t128(t128_t packed, unsigned trit_count)
+/* Exact t128 values need ~203 bits; work in 3^64 limbs on top of the t64 path. */
+typedef signed _BitInt(256) ternary_value_t128;
+
+static ternary_value_t128 ternary_decode_t128(t128_t packed, unsigned trit_count)
 {
-    int64_t value = 0;
-    int64_t pow3 = 1;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = ternary_get_trit_t128(packed, i);
-        value += (int64_t)trit * pow3;
-        pow3 *= 3;
+    if (trit_count <= 64)
+        return ternary_decode_u128((unsigned __int128)packed, trit_count);
+    ternary_value_t128 pow3_64 = (ternary_value_t128)TERNARY_POW3_32 * TERNARY_POW3_32;
+    ternary_value_t128 high = ternary_decode_u128((unsigned __int128)(packed >> 128), trit_count - 64);
+    return high * pow3_64 + ternary_decode_u128((unsigned __int128)packed, 64);
+}
+
+static t128_t ternary_encode_t128(ternary_value_t128 value, unsigned trit_count)
+{
+    ternary_value_t128 pow3_64 = (ternary_value_t128)TERNARY_POW3_32 * TERNARY_POW3_32;
+    ternary_value_t128 low = value % pow3_64;
+    if (trit_count <= 64)
+        return ternary_encode_u128((__int128)low, trit_count);
+    ternary_value_t128 high = (value - low) / pow3_64;
+    if (low > pow3_64 / 2) {
+        low -= pow3_64;
+        high += 1;
+    } else if (low < -(pow3_64 / 2)) {
+        low += pow3_64;
+        high -= 1;
     }
-    return value;
+    t128_t packed_high = ternary_encode_u128((__int128)(high % pow3_64), trit_count - 64);
+    return (packed_high << 128) | ternary_encode_u128((__int128)low, 64);
 }
 
-static t128_t ternary_encode_t128(int64_t value, unsigned trit_count)
+static ternary_value_t128 ternary_mulmod_t128(ternary_value_t128 a, ternary_value_t128 b)
 {
-    t128_t packed = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int64_t rem = value % 3;
-        value /= 3;
+    ternary_value_t128 pow3_64 = (ternary_value_t128)TERNARY_POW3_32 * TERNARY_POW3_32;
+    ternary_value_t128 a0 = a % pow3_64;
+    ternary_value_t128 b0 = b % pow3_64;
+    ternary_value_t128 a1 = (a - a0) / pow3_64;
+    ternary_value_t128 b1 = (b - b0) / pow3_64;
+    ternary_value_t128 cross = (a1 * b0 + a0 * b1) % pow3_64;
+    return cross * pow3_64 + a0 * b0;
+}
 
-        if (rem == 2) {
-            rem = -1;
-            value += 1;
-        } else if (rem == -2) {
-            rem = 1;
-            value -= 1;
-        }
+static int ternary_popcount_t128(t128_t mask)
+{
+    int count = 0;
+    for (unsigned limb = 0; limb < 4; ++limb)
+        count += __builtin_popcountll((uint64_t)(mask >> (64U * limb)));
+    return count;
+}
 
-        t128_t bits = (t128_t)ternary_trit_to_bits((int)rem) << (2U * i);
-        packed |= bits;
-    }
-    return packed;
+static int ternary_tnet_t128(t128_t packed)
+{
+    return ternary_popcount_t128(ternary_plus_mask_t128(packed)) -
+           ternary_popcount_t128(ternary_minus_mask_t128(packed));
 }
 
-static int ternary_sign_t128(t128_t packed, unsigned trit_count)
+static int ternary_sign_t128(t128_t packed)
 {
-    for (int i = (int)trit_count - 1; i >= 0; --i) {
-        int trit = ternary_get_trit_t128(packed, (unsigned)i);
-        if (trit != 0)
-            return trit;
-    }
-    return 0;
+    t128_t plus = ternary_plus_mask_t128(packed);
+    t128_t minus = ternary_minus_mask_t128(packed);
+    return (plus > minus) - (plus < minus);
 }
 
 static t128_t ternary_tequiv_t128(t128_t a, t128_t b)
 {
-    int sign_a = ternary_sign_t128(a, 128);
-    int sign_b = ternary_sign_t128(b, 128);
-    int trit = 0;
-    if (sign_a == 0 || sign_b == 0)
-        trit = 0;
-    else if (sign_a == sign_b)
-        trit = 1;
-    else
-        trit = -1;
-    return ternary_encode_t128(trit, 128);
+    int trit = ternary_equiv_sign(ternary_sign_t128(a), ternary_sign_t128(b));
+    return TERNARY_TRIT_LSB_T128 + (t128_t)trit;
 }
 
 static t128_t ternary_txor_t128(t128_t a, t128_t b)
 {
-    int sign_a = ternary_sign_t128(a, 128);
-    int sign_b = ternary_sign_t128(b, 128);
-    int trit = 0;
-    if (sign_a == sign_b && sign_a != 0)
-        trit = -1;
-    else if (sign_b == 0 && sign_a != 0)
-        trit = 1;
-    else if (sign_a == 0 && sign_b != 0)
-        trit = 1;
-    else
-        trit = 0;
-    return ternary_encode_t128(trit, 128);
+    int trit = ternary_xor_sign(ternary_sign_t128(a), ternary_sign_t128(b));
+    return TERNARY_TRIT_LSB_T128 + (t128_t)trit;
 }
 
 static t128_t ternary_tmux_u128(t128_t sel, t128_t neg, t128_t zero, t128_t pos)
 {
-    int cond = ternary_sign_t128(sel, 128);
+    int cond = ternary_sign_t128(sel);
     if (cond < 0)
         return neg;
     if (cond > 0)
         return pos;
     return zero;
 }
-#endif
 
-static uint64_t ternary_shift_left(uint64_t packed, unsigned trit_count, unsigned shift)
+static t128_t ternary_digits_t128(t128_t packed)
 {
-    uint64_t out = 0;
-    if (trit_count == 0)
-        return packed;
-    shift %= trit_count;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = 0;
-        if (i >= shift)
-            trit = ternary_get_trit(packed, i - shift);
-        out = ternary_set_trit(out, i, trit);
-    }
-    return out;
+    return packed & ~(packed & (packed >> 1) & TERNARY_TRIT_LSB_T128);
 }
 
-static uint64_t ternary_shift_right(uint64_t packed, unsigned trit_count, unsigned shift)
+static t128_t ternary_digit_add_t128(t128_t a, t128_t b)
 {
-    uint64_t out = 0;
-    if (trit_count == 0)
-        return packed;
-    shift %= trit_count;
-    int sign_trit = ternary_get_trit(packed, trit_count - 1);
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = sign_trit;
-        if (i + shift < trit_count)
-            trit = ternary_get_trit(packed, i + shift);
-        out = ternary_set_trit(out, i, trit);
-    }
-    return out;
+    t128_t biased = a + TERNARY_TRIT_LSB_T128;
+    t128_t sum = biased + b;
+    t128_t carry = ((biased ^ b ^ sum) >> 2) & TERNARY_TRIT_LSB_T128;
+    carry |= (t128_t)(sum < biased) << 254;
+    return sum - (TERNARY_TRIT_LSB_T128 & ~carry);
 }
 
-static uint64_t ternary_rotate_left(uint64_t packed, unsigned trit_count, unsigned shift)
+static t128_t ternary_add_t128(t128_t a, t128_t b)
 {
-    uint64_t out = 0;
-    if (trit_count == 0)
-        return packed;
-    shift %= trit_count;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        unsigned src = (i + trit_count - shift) % trit_count;
-        int trit = ternary_get_trit(packed, src);
-        out = ternary_set_trit(out, i, trit);
-    }
-    return out;
+    t128_t sum = ternary_digit_add_t128(ternary_digits_t128(a), ternary_digits_t128(b));
+    return ternary_digit_add_t128(sum, TERNARY_TRIT_LSB_T128 + 1U);
 }
 
-static uint64_t ternary_rotate_right(uint64_t packed, unsigned trit_count, unsigned shift)
+static t128_t ternary_neg_t128(t128_t packed)
 {
-    uint64_t out = 0;
-    if (trit_count == 0)
-        return packed;
-    shift %= trit_count;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        unsigned src = (i + shift) % trit_count;
-        int trit = ternary_get_trit(packed, src);
-        out = ternary_set_trit(out, i, trit);
-    }
-    return out;
+    return (TERNARY_TRIT_LSB_T128 << 1) - ternary_digits_t128(packed);
 }
 
-static int64_t ternary_decode_u128(unsigned __int128 packed, unsigned trit_count)
-{
-    int64_t value = 0;
-    int64_t pow3 = 1;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        unsigned bits = (unsigned)((packed >> (2U * i)) & 0x3U);
-        int trit = ternary_bits_to_trit(bits);
-        value += (int64_t)trit * pow3;
-        pow3 *= 3;
+DEFINE_TERNARY_SHIFT_OPS(t128, t128_t, TERNARY_TRIT_LSB_T128, ternary_digits_t128)
+#endif
+
+/* Wide values are handled as two base-3^32 limbs so every limb fits the exact
+ * int64 path; 3^64 still fits in __int128, so t64 values are exact. */
+static __int128 ternary_decode_u128(unsigned __int128 packed, unsigned trit_count)
+{
+    if (trit_count <= 32)
+        return ternary_decode((uint64_t)packed, trit_count);
+    __int128 high = ternary_decode((uint64_t)(packed >> 64), trit_count - 32);
+    return high * TERNARY_POW3_32 + ternary_decode((uint64_t)packed, 32);
+}
+
+static unsigned __int128 ternary_encode_u128(__int128 value, unsigned trit_count)
+{
+    __int128 low = value % TERNARY_POW3_32;
+    if (trit_count <= 32)
+        return ternary_encode((int64_t)low, trit_count);
+    __int128 high = (value - low) / TERNARY_POW3_32;
+    /* Keep the low limb balanced so its encoding carries nothing upward. */
+    if (low > TERNARY_POW3_32 / 2) {
+        low -= TERNARY_POW3_32;
+        high += 1;
+    } else if (low < -(TERNARY_POW3_32 / 2)) {
+        low += TERNARY_POW3_32;
+        high -= 1;
     }
-    return value;
+    uint64_t packed_high = ternary_encode((int64_t)(high % TERNARY_POW3_32), trit_count - 32);
+    return ((unsigned __int128)packed_high << 64) | ternary_encode((int64_t)low, 32);
 }
 
-static unsigned __int128 ternary_encode_u128(int64_t value, unsigned trit_count)
+/* a * b mod 3^64 without a 256-bit product: with a = a1 * 3^32 + a0, the
+ * a1 * b1 term is a multiple of 3^64 and the cross terms only matter mod 3^32. */
+static __int128 ternary_mulmod_t64(__int128 a, __int128 b)
 {
-    unsigned __int128 packed = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int64_t rem = value % 3;
-        value /= 3;
-
-        if (rem == 2) {
-            rem = -1;
-            value += 1;
-        } else if (rem == -2) {
-            rem = 1;
-            value -= 1;
-        }
-
-        unsigned bits = ternary_trit_to_bits((int)rem);
-        packed |= ((unsigned __int128)bits) << (2U * i);
-    }
-    return packed;
+    __int128 a0 = a % TERNARY_POW3_32;
+    __int128 b0 = b % TERNARY_POW3_32;
+    __int128 a1 = (a - a0) / TERNARY_POW3_32;
+    __int128 b1 = (b - b0) / TERNARY_POW3_32;
+    __int128 cross = (a1 * b0 + a0 * b1) % TERNARY_POW3_32;
+    return cross * TERNARY_POW3_32 + a0 * b0;
 }
 
-t32_t __ternary_bt_str_t32(const char *s)
+static unsigned __int128 ternary_mul_u128(unsigned __int128 a, unsigned __int128 b)
 {
-    int64_t value = 0;
-    if (!ternary_parse_bt_str(s, &value))
-        return 0;
-    return (t32_t)ternary_encode(value, 32);
+    return ternary_encode_u128(ternary_mulmod_t64(ternary_decode_u128(a, 64),
+                                                  ternary_decode_u128(b, 64)), 64);
 }
 
-t64_t __ternary_bt_str_t64(const char *s)
+static unsigned __int128 ternary_digits_u128(unsigned __int128 packed)
 {
-    int64_t value = 0;
-    if (!ternary_parse_bt_str(s, &value))
-        return 0;
-    return (t64_t)ternary_encode_u128(value, 64);
+    return packed & ~(packed & (packed >> 1) & TERNARY_TRIT_LSB_U128);
 }
 
-static int ternary_get_trit_u128(unsigned __int128 packed, unsigned idx)
+static unsigned __int128 ternary_digit_add_u128(unsigned __int128 a, unsigned __int128 b)
 {
-    unsigned bits = (unsigned)((packed >> (2U * idx)) & 0x3U);
-    return ternary_bits_to_trit(bits);
+    unsigned __int128 biased = a + TERNARY_TRIT_LSB_U128;
+    unsigned __int128 sum = biased + b;
+    unsigned __int128 carry = ((biased ^ b ^ sum) >> 2) & TERNARY_TRIT_LSB_U128;
+    carry |= (unsigned __int128)(sum < biased) << 126;
+    return sum - (TERNARY_TRIT_LSB_U128 & ~carry);
 }
 
-static unsigned __int128 ternary_set_trit_u128(unsigned __int128 packed, unsigned idx, int trit)
+static unsigned __int128 ternary_add_u128(unsigned __int128 a, unsigned __int128 b)
 {
-    unsigned __int128 mask = (unsigned __int128)0x3U << (2U * idx);
-    unsigned __int128 bits = (unsigned __int128)ternary_trit_to_bits(trit) << (2U * idx);
-    return (packed & ~mask) | bits;
+    unsigned __int128 sum = ternary_digit_add_u128(ternary_digits_u128(a), ternary_digits_u128(b));
+    return ternary_digit_add_u128(sum, TERNARY_TRIT_LSB_U128 + 1U);
 }
 
-static unsigned __int128 ternary_tritwise_op_u128(unsigned __int128 a, unsigned __int128 b,
-                                                  unsigned trit_count, int op)
+static unsigned __int128 ternary_neg_u128(unsigned __int128 packed)
 {
-    unsigned __int128 out = 0;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int ta = ternary_get_trit_u128(a, i);
-        int tb = ternary_get_trit_u128(b, i);
-        int trit = 0;
-        if (op == 0)
-            trit = ternary_trit_min(ta, tb);
-        else if (op == 1)
-            trit = ternary_trit_max(ta, tb);
-        else
-            trit = ternary_trit_xor(ta, tb);
-        out = ternary_set_trit_u128(out, i, trit);
-    }
-    return out;
+    return (TERNARY_TRIT_LSB_U128 << 1) - ternary_digits_u128(packed);
 }
 
-static unsigned __int128 ternary_shift_left_u128(unsigned __int128 packed, unsigned trit_count,
-                                                 unsigned shift)
+static unsigned __int128 ternary_sub_u128(unsigned __int128 a, unsigned __int128 b)
 {
-    unsigned __int128 out = 0;
-    if (trit_count == 0)
-        return packed;
-    shift %= trit_count;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = 0;
-        if (i >= shift)
-            trit = ternary_get_trit_u128(packed, i - shift);
-        out = ternary_set_trit_u128(out, i, trit);
-    }
-    return out;
+    return ternary_add_u128(a, ternary_neg_u128(b));
 }
 
-static unsigned __int128 ternary_shift_right_u128(unsigned __int128 packed, unsigned trit_count,
-                                                  unsigned shift)
+DEFINE_TERNARY_SHIFT_OPS(u128, unsigned __int128, TERNARY_TRIT_LSB_U128, ternary_digits_u128)
+
+t32_t __ternary_bt_str_t32(const char *s)
 {
-    unsigned __int128 out = 0;
-    if (trit_count == 0)
-        return packed;
-    shift %= trit_count;
-    int sign_trit = ternary_get_trit_u128(packed, trit_count - 1);
-    for (unsigned i = 0; i < trit_count; ++i) {
-        int trit = sign_trit;
-        if (i + shift < trit_count)
-            trit = ternary_get_trit_u128(packed, i + shift);
-        out = ternary_set_trit_u128(out, i, trit);
-    }
-    return out;
+    int64_t value = 0;
+    if (!ternary_parse_bt_str(s, &value))
+        return 0;
+    return (t32_t)ternary_encode(value, 32);
 }
 
-static unsigned __int128 ternary_rotate_left_u128(unsigned __int128 packed, unsigned trit_count,
-                                                  unsigned shift)
+t64_t __ternary_bt_str_t64(const char *s)
 {
-    unsigned __int128 out = 0;
-    if (trit_count == 0)
-        return packed;
-    shift %= trit_count;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        unsigned src = (i + trit_count - shift) % trit_count;
-        int trit = ternary_get_trit_u128(packed, src);
-        out = ternary_set_trit_u128(out, i, trit);
-    }
-    return out;
+    int64_t value = 0;
+    if (!ternary_parse_bt_str(s, &value))
+        return 0;
+    return (t64_t)ternary_encode_u128(value, 64);
 }
 
-static unsigned __int128 ternary_rotate_right_u128(unsigned __int128 packed, unsigned trit_count,
-                                                   unsigned shift)
+static unsigned __int128 ternary_set_trit_u128(unsigned __int128 packed, unsigned idx, int trit)
 {
-    unsigned __int128 out = 0;
-    if (trit_count == 0)
-        return packed;
-    shift %= trit_count;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        unsigned src = (i + shift) % trit_count;
-        int trit = ternary_get_trit_u128(packed, src);
-        out = ternary_set_trit_u128(out, i, trit);
-    }
-    return out;
+    unsigned __int128 mask = (unsigned __int128)0x3U << (2U * idx);
+    unsigned __int128 bits = (unsigned __int128)ternary_trit_to_bits(trit) << (2U * idx);
+    return (packed & ~mask) | bits;
 }
 
 int __ternary_select_i8(TERNARY_COND_T cond, int true_val, int false_val)
@@ -998,62 +938,56 @@ int __ternary_ge(int a, int b)
     return cmp == 1 || cmp == 0 ? 1 : 0;
 }
 
-#define DEFINE_TERNARY_TYPE_OPS(TRITS, TYPE, SUFFIX, PACK_T, DECODE, ENCODE, TRIT_OP, SHL, SHR, ROL, ROR) \
+#define DEFINE_TERNARY_TYPE_OPS(TRITS, TYPE, SUFFIX, PACK_T, VALUE_T, ZERO, DECODE, ENCODE, \
+                                DIGITS, ADD, SUB, NEG, MUL, TMIN, TMAX, TXOR, SHL, SHR, \
+                                ROL, ROR) \
     TYPE __ternary_select_t##SUFFIX(TERNARY_COND_T cond, TYPE true_val, TYPE false_val) \
     { \
         return cond ? true_val : false_val; \
     } \
     TYPE __ternary_add_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int64_t va = DECODE((PACK_T)a, TRITS); \
-        int64_t vb = DECODE((PACK_T)b, TRITS); \
-        return (TYPE)ENCODE(va + vb, TRITS); \
+        return (TYPE)ADD((PACK_T)a, (PACK_T)b); \
     } \
     TYPE __ternary_mul_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int64_t va = DECODE((PACK_T)a, TRITS); \
-        int64_t vb = DECODE((PACK_T)b, TRITS); \
-        return (TYPE)ENCODE(va * vb, TRITS); \
+        return (TYPE)MUL((PACK_T)a, (PACK_T)b); \
     } \
     TYPE __ternary_not_t##SUFFIX(TYPE a) \
     { \
-        int64_t va = DECODE((PACK_T)a, TRITS); \
-        return (TYPE)ENCODE(-va, TRITS); \
+        return (TYPE)NEG((PACK_T)a); \
     } \
     TYPE __ternary_sub_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int64_t va = DECODE((PACK_T)a, TRITS); \
-        int64_t vb = DECODE((PACK_T)b, TRITS); \
-        return (TYPE)ENCODE(va - vb, TRITS); \
+        return (TYPE)SUB((PACK_T)a, (PACK_T)b); \
     } \
     TYPE __ternary_div_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int64_t va = DECODE((PACK_T)a, TRITS); \
-        int64_t vb = DECODE((PACK_T)b, TRITS); \
+        VALUE_T va = DECODE((PACK_T)a, TRITS); \
+        VALUE_T vb = DECODE((PACK_T)b, TRITS); \
         return (TYPE)ENCODE(vb == 0 ? 0 : va / vb, TRITS); \
     } \
     TYPE __ternary_mod_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int64_t va = DECODE((PACK_T)a, TRITS); \
-        int64_t vb = DECODE((PACK_T)b, TRITS); \
+        VALUE_T va = DECODE((PACK_T)a, TRITS); \
+        VALUE_T vb = DECODE((PACK_T)b, TRITS); \
         return (TYPE)ENCODE(vb == 0 ? 0 : va % vb, TRITS); \
     } \
     TYPE __ternary_neg_t##SUFFIX(TYPE a) \
     { \
-        int64_t va = DECODE((PACK_T)a, TRITS); \
-        return (TYPE)ENCODE(-va, TRITS); \
+        return (TYPE)NEG((PACK_T)a); \
     } \
     TYPE __ternary_and_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        return (TYPE)TRIT_OP((PACK_T)a, (PACK_T)b, TRITS, 0); \
+        return (TYPE)TMIN((PACK_T)a, (PACK_T)b); \
     } \
     TYPE __ternary_or_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        return (TYPE)TRIT_OP((PACK_T)a, (PACK_T)b, TRITS, 1); \
+        return (TYPE)TMAX((PACK_T)a, (PACK_T)b); \
     } \
     TYPE __ternary_xor_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        return (TYPE)TRIT_OP((PACK_T)a, (PACK_T)b, TRITS, 2); \
+        return (TYPE)TXOR((PACK_T)a, (PACK_T)b); \
     } \
     TYPE __ternary_shl_t##SUFFIX(TYPE a, int shift) \
     { \
@@ -1077,7 +1011,7 @@ int __ternary_ge(int a, int b)
     } \
     int64_t __ternary_tt2b_t##SUFFIX(TYPE v) \
     { \
-        return DECODE((PACK_T)v, TRITS); \
+        return (int64_t)DECODE((PACK_T)v, TRITS); \
     } \
     float __ternary_t2f32_t##SUFFIX(TYPE v) \
     { \
@@ -1089,95 +1023,93 @@ int __ternary_ge(int a, int b)
     } \
     TYPE __ternary_f2t32_t##SUFFIX(float v) \
     { \
-        return (TYPE)ENCODE((int64_t)v, TRITS); \
+        return (TYPE)ENCODE((VALUE_T)v, TRITS); \
     } \
     TYPE __ternary_f2t64_t##SUFFIX(double v) \
     { \
-        return (TYPE)ENCODE((int64_t)v, TRITS); \
+        return (TYPE)ENCODE((VALUE_T)v, TRITS); \
     } \
+    /* Valid packed words order like their values, so compares never decode. */ \
     int __ternary_cmp_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int64_t va = DECODE((PACK_T)a, TRITS); \
-        int64_t vb = DECODE((PACK_T)b, TRITS); \
-        if (va < vb) \
-            return -1; \
-        if (va > vb) \
-            return 1; \
-        return 0; \
+        PACK_T da = DIGITS((PACK_T)a); \
+        PACK_T db = DIGITS((PACK_T)b); \
+        return (da > db) - (da < db); \
     } \
     int __ternary_eq_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        return __ternary_cmp_t##SUFFIX(a, b) == 0 ? 1 : 0; \
+        return DIGITS((PACK_T)a) == DIGITS((PACK_T)b); \
     } \
     int __ternary_ne_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        return __ternary_cmp_t##SUFFIX(a, b) != 0 ? 1 : 0; \
+        return DIGITS((PACK_T)a) != DIGITS((PACK_T)b); \
     } \
     int __ternary_lt_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        return __ternary_cmp_t##SUFFIX(a, b) == -1 ? 1 : 0; \
+        return DIGITS((PACK_T)a) < DIGITS((PACK_T)b); \
     } \
     int __ternary_le_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int cmp = __ternary_cmp_t##SUFFIX(a, b); \
-        return cmp == -1 || cmp == 0 ? 1 : 0; \
+        return DIGITS((PACK_T)a) <= DIGITS((PACK_T)b); \
     } \
     int __ternary_gt_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        return __ternary_cmp_t##SUFFIX(a, b) == 1 ? 1 : 0; \
+        return DIGITS((PACK_T)a) > DIGITS((PACK_T)b); \
     } \
     int __ternary_ge_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int cmp = __ternary_cmp_t##SUFFIX(a, b); \
-        return cmp == 1 || cmp == 0 ? 1 : 0; \
+        return DIGITS((PACK_T)a) >= DIGITS((PACK_T)b); \
     } \
-    /* Ternary-specific comparison operations returning ternary results */ \
+    /* Ternary-specific comparison operations returning ternary results. \
+     * ZERO +/- 1 only touches the low trit, giving the packed -1/0/+1 words. */ \
     TYPE __ternary_cmplt_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int cmp = __ternary_cmp_t##SUFFIX(a, b); \
-        return (TYPE)ENCODE(cmp == -1 ? -1 : 0, TRITS); \
+        return (TYPE)(ZERO - (PACK_T)__ternary_lt_t##SUFFIX(a, b)); \
     } \
     TYPE __ternary_cmpeq_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int cmp = __ternary_cmp_t##SUFFIX(a, b); \
-        return (TYPE)ENCODE(cmp == 0 ? 1 : 0, TRITS); \
+        return (TYPE)(ZERO + (PACK_T)__ternary_eq_t##SUFFIX(a, b)); \
     } \
     TYPE __ternary_cmpgt_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int cmp = __ternary_cmp_t##SUFFIX(a, b); \
-        return (TYPE)ENCODE(cmp == 1 ? 1 : 0, TRITS); \
+        return (TYPE)(ZERO + (PACK_T)__ternary_gt_t##SUFFIX(a, b)); \
     } \
     TYPE __ternary_cmpneq_t##SUFFIX(TYPE a, TYPE b) \
     { \
-        int cmp = __ternary_cmp_t##SUFFIX(a, b); \
-        return (TYPE)ENCODE(cmp != 0 ? 1 : 0, TRITS); \
+        return (TYPE)(ZERO + (PACK_T)__ternary_ne_t##SUFFIX(a, b)); \
     }
 
-DEFINE_TERNARY_TYPE_OPS(32, t32_t, 32, uint64_t, ternary_decode, ternary_encode,
-                        ternary_tritwise_op, ternary_shift_left, ternary_shift_right,
-                        ternary_rotate_left, ternary_rotate_right)
-DEFINE_TERNARY_TYPE_OPS(64, t64_t, 64, unsigned __int128, ternary_decode_u128, ternary_encode_u128,
-                        ternary_tritwise_op_u128, ternary_shift_left_u128, ternary_shift_right_u128,
+DEFINE_TERNARY_TYPE_OPS(32, t32_t, 32, uint64_t, int64_t, TERNARY_TRIT_LSB_U64,
+                        ternary_decode, ternary_encode, ternary_digits_u64,
+                        ternary_add_u64, ternary_sub_u64, ternary_neg_u64, ternary_mul_u64,
+                        ternary_tmin_u64, ternary_tmax_u64, ternary_xor_u64,
+                        ternary_shift_left_u64, ternary_shift_right_u64,
+                        ternary_rotate_left_u64, ternary_rotate_right_u64)
+DEFINE_TERNARY_TYPE_OPS(64, t64_t, 64, unsigned __int128, __int128, TERNARY_TRIT_LSB_U128,
+                        ternary_decode_u128, ternary_encode_u128, ternary_digits_u128,
+                        ternary_add_u128, ternary_sub_u128, ternary_neg_u128, ternary_mul_u128,
+                        ternary_tmin_u128, ternary_tmax_u128, ternary_xor_u128,
+                        ternary_shift_left_u128, ternary_shift_right_u128,
                         ternary_rotate_left_u128, ternary_rotate_right_u128)
 
 t32_t __ternary_tmin_t32(t32_t a, t32_t b)
 {
-    return (t32_t)ternary_tritwise_op((uint64_t)a, (uint64_t)b, 32, 0);
+    return (t32_t)ternary_tmin_u64((uint64_t)a, (uint64_t)b);
 }
 
 t32_t __ternary_tmax_t32(t32_t a, t32_t b)
 {
-    return (t32_t)ternary_tritwise_op((uint64_t)a, (uint64_t)b, 32, 1);
+    return (t32_t)ternary_tmax_u64((uint64_t)a, (uint64_t)b);
 }
 
 t32_t __ternary_tmaj_t32(t32_t a, t32_t b, t32_t c)
 {
-    return (t32_t)ternary_majority_u64((uint64_t)a, (uint64_t)b, (uint64_t)c, 32);
+    return (t32_t)ternary_tmaj_u64((uint64_t)a, (uint64_t)b, (uint64_t)c);
 }
 
 t32_t __ternary_tlimp_t32(t32_t antecedent, t32_t consequent)
 {
-    return (t32_t)ternary_implication_u64((uint64_t)antecedent, (uint64_t)consequent, 32);
+    return (t32_t)ternary_tlimp_u64((uint64_t)antecedent, (uint64_t)consequent);
 }
 
 t32_t __ternary_tquant_t32(float value, float threshold)
@@ -1187,7 +1119,7 @@ t32_t __ternary_tquant_t32(float value, float threshold)
 
 t32_t __ternary_tnot_t32(t32_t a)
 {
-    return (t32_t)ternary_not_u64((uint64_t)a, 32);
+    return (t32_t)ternary_tnot_u64((uint64_t)a);
 }
 
 t32_t __ternary_tinv_t32(t32_t a)
@@ -1207,7 +1139,7 @@ t32_t __ternary_tround_t32(t32_t a, unsigned drop)
 
 t32_t __ternary_tnormalize_t32(t32_t a)
 {
-    return (t32_t)ternary_normalize_u64((uint64_t)a, 32);
+    return (t32_t)ternary_tnormalize_u64((uint64_t)a);
 }
 
 t32_t __ternary_tbias_t32(t32_t a, int64_t bias)
@@ -1225,9 +1157,9 @@ t32_t __ternary_txor_t32(t32_t a, t32_t b)
     return ternary_txor_t32(a, b);
 }
 
-int __ternary_tnet_t32(t32_t a)
+int TERNARY_DISPATCHED(__ternary_tnet_t32)(t32_t a)
 {
-    return (int)ternary_decode((uint64_t)a, 32);
+    return ternary_tnet_u64((uint64_t)a);
 }
 
 t32_t __ternary_tmux_t32(t32_t sel, t32_t neg, t32_t zero, t32_t pos)
@@ -1237,24 +1169,24 @@ t32_t __ternary_tmux_t32(t32_t sel, t32_t neg, t32_t zero, t32_t pos)
 
 t64_t __ternary_tmin_t64(t64_t a, t64_t b)
 {
-    return (t64_t)ternary_tritwise_op_u128((unsigned __int128)a, (unsigned __int128)b, 64, 0);
+    return (t64_t)ternary_tmin_u128((unsigned __int128)a, (unsigned __int128)b);
 }
 
 t64_t __ternary_tmax_t64(t64_t a, t64_t b)
 {
-    return (t64_t)ternary_tritwise_op_u128((unsigned __int128)a, (unsigned __int128)b, 64, 1);
+    return (t64_t)ternary_tmax_u128((unsigned __int128)a, (unsigned __int128)b);
 }
 
 t64_t __ternary_tmaj_t64(t64_t a, t64_t b, t64_t c)
 {
-    return (t64_t)ternary_majority_u128((unsigned __int128)a, (unsigned __int128)b,
-                                         (unsigned __int128)c, 64);
+    return (t64_t)ternary_tmaj_u128((unsigned __int128)a, (unsigned __int128)b,
+                                     (unsigned __int128)c);
 }
 
 t64_t __ternary_tlimp_t64(t64_t antecedent, t64_t consequent)
 {
-    return (t64_t)ternary_implication_u128((unsigned __int128)antecedent,
-                                            (unsigned __int128)consequent, 64);
+    return (t64_t)ternary_tlimp_u128((unsigned __int128)antecedent,
+                                      (unsigned __int128)consequent);
 }
 
 t64_t __ternary_tquant_t64(double value, double threshold)
@@ -1264,7 +1196,7 @@ t64_t __ternary_tquant_t64(double value, double threshold)
 
 t64_t __ternary_tnot_t64(t64_t a)
 {
-    return (t64_t)ternary_not_u128((unsigned __int128)a, 64);
+    return (t64_t)ternary_tnot_u128((unsigned __int128)a);
 }
 
 t64_t __ternary_tinv_t64(t64_t a)
@@ -1285,7 +1217,7 @@ t64_t __ternary_tround_t64(t64_t a, unsigned drop)
 
 t64_t __ternary_tnormalize_t64(t64_t a)
 {
-    return (t64_t)ternary_normalize_u128((unsigned __int128)a, 64);
+    return (t64_t)ternary_tnormalize_u128((unsigned __int128)a);
 }
 
 t64_t __ternary_tbias_t64(t64_t a, int64_t bias)
@@ -1303,9 +1235,9 @@ t64_t __ternary_txor_t64(t64_t a, t64_t b)
     return ternary_txor_t64(a, b);
 }
 
-int __ternary_tnet_t64(t64_t a)
+int TERNARY_DISPATCHED(__ternary_tnet_t64)(t64_t a)
 {
-    return (int)ternary_decode_u128((unsigned __int128)a, 64);
+    return ternary_tnet_u128((unsigned __int128)a);
 }
 
 t64_t __ternary_tmux_t64(t64_t sel, t64_t neg, t64_t zero, t64_t pos)
@@ -1320,15 +1252,80 @@ int __ternary_tbranch(TERNARY_COND_T cond, int neg_target, int zero_target, int
 
 int __ternary_tsignjmp_t32(t32_t reg, int neg_target, int zero_target, int pos_target)
 {
-    return ternary_signjmp_u64((uint64_t)reg, 32, neg_target, zero_target, pos_target);
+    return ternary_branch_target(ternary_sign_u64((uint64_t)reg), neg_target, zero_target,
+                                 pos_target);
 }
 
 int __ternary_tsignjmp_t64(t64_t reg, int neg_target, int zero_target, int pos_target)
 {
-    return ternary_signjmp_u128((unsigned __int128)reg, 64, neg_target, zero_target, pos_target);
+    return ternary_branch_target(ternary_sign_u128((unsigned __int128)reg), neg_target, zero_target,
+                                 pos_target);
 }
 
 #if defined(__BITINT_MAXWIDTH__) && __BITINT_MAXWIDTH__ >= 256 && !defined(__cplusplus)
+t128_t __ternary_select_t128(TERNARY_COND_T cond, t128_t true_val, t128_t false_val)
+{
+    return cond ? true_val : false_val;
+}
+
+/* Valid packed words order like their values, so compares never decode. */
+int __ternary_cmp_t128(t128_t a, t128_t b)
+{
+    t128_t da = ternary_digits_t128(a);
+    t128_t db = ternary_digits_t128(b);
+    return (da > db) - (da < db);
+}
+
+t128_t __ternary_not_t128(t128_t a)
+{
+    return ternary_neg_t128(a);
+}
+
+t128_t __ternary_and_t128(t128_t a, t128_t b)
+{
+    return ternary_tmin_t128(a, b);
+}
+
+t128_t __ternary_or_t128(t128_t a, t128_t b)
+{
+    return ternary_tmax_t128(a, b);
+}
+
+t128_t __ternary_tmin_t128(t128_t a, t128_t b)
+{
+    return ternary_tmin_t128(a, b);
+}
+
+t128_t __ternary_tmax_t128(t128_t a, t128_t b)
+{
+    return ternary_tmax_t128(a, b);
+}
+
+t128_t __ternary_tmaj_t128(t128_t a, t128_t b, t128_t c)
+{
+    return ternary_tmaj_t128(a, b, c);
+}
+
+t128_t __ternary_tlimp_t128(t128_t antecedent, t128_t consequent)
+{
+    return ternary_tlimp_t128(antecedent, consequent);
+}
+
+t128_t __ternary_tnot_t128(t128_t a)
+{
+    return ternary_tnot_t128(a);
+}
+
+t128_t __ternary_tinv_t128(t128_t a)
+{
+    return ternary_tnot_t128(a);
+}
+
+t128_t __ternary_tnormalize_t128(t128_t a)
+{
+    return ternary_tnormalize_t128(a);
+}
+
 t128_t __ternary_tequiv_t128(t128_t a, t128_t b)
 {
     return ternary_tequiv_t128(a, b);
@@ -1341,7 +1338,7 @@ t128_t __ternary_txor_t128(t128_t a, t128_t b)
 
 int __ternary_tnet_t128(t128_t a)
 {
-    return (int)ternary_decode_t128(a, 128);
+    return ternary_tnet_t128(a);
 }
 
 t128_t __ternary_tmux_t128(t128_t sel, t128_t neg, t128_t zero, t128_t pos)
@@ -1356,7 +1353,77 @@ t128_t __ternary_tb2t_t128(int64_t v)
 
 int64_t __ternary_tt2b_t128(t128_t v)
 {
-    return ternary_decode_t128(v, 128);
+    return (int64_t)ternary_decode_t128(v, 128);
+}
+
+t128_t __ternary_add_t128(t128_t a, t128_t b)
+{
+    return ternary_add_t128(a, b);
+}
+
+t128_t __ternary_sub_t128(t128_t a, t128_t b)
+{
+    return ternary_add_t128(a, ternary_neg_t128(b));
+}
+
+t128_t __ternary_neg_t128(t128_t a)
+{
+    return ternary_neg_t128(a);
+}
+
+t128_t __ternary_mul_t128(t128_t a, t128_t b)
+{
+    return ternary_encode_t128(ternary_mulmod_t128(ternary_decode_t128(a, 128),
+                                                   ternary_decode_t128(b, 128)), 128);
+}
+
+t128_t __ternary_tmuladd_t128(t128_t a, t128_t b, t128_t c)
+{
+    return ternary_add_t128(__ternary_mul_t128(a, b), c);
+}
+
+t128_t __ternary_div_t128(t128_t a, t128_t b)
+{
+    ternary_value_t128 va = ternary_decode_t128(a, 128);
+    ternary_value_t128 vb = ternary_decode_t128(b, 128);
+    return ternary_encode_t128(vb == 0 ? 0 : va / vb, 128);
+}
+
+t128_t __ternary_tround_t128(t128_t a, unsigned drop)
+{
+    if (drop >= 128)
+        return TERNARY_TRIT_LSB_T128;
+    ternary_value_t128 divisor = 1;
+    for (unsigned i = 0; i < drop; ++i)
+        divisor *= 3;
+    return ternary_encode_t128(ternary_decode_t128(a, 128) / divisor, 128);
+}
+
+t128_t __ternary_mod_t128(t128_t a, t128_t b)
+{
+    ternary_value_t128 va = ternary_decode_t128(a, 128);
+    ternary_value_t128 vb = ternary_decode_t128(b, 128);
+    return ternary_encode_t128(vb == 0 ? 0 : va % vb, 128);
+}
+
+t128_t __ternary_shl_t128(t128_t a, int shift)
+{
+    return ternary_shift_left_t128(a, 128, (unsigned)shift);
+}
+
+t128_t __ternary_shr_t128(t128_t a, int shift)
+{
+    return ternary_shift_right_t128(a, 128, (unsigned)shift);
+}
+
+t128_t __ternary_rol_t128(t128_t a, int shift)
+{
+    return ternary_rotate_left_t128(a, 128, (unsigned)shift);
+}
+
+t128_t __ternary_ror_t128(t128_t a, int shift)
+{
+    return ternary_rotate_right_t128(a, 128, (unsigned)shift);
 }
 #endif
 
@@ -1380,6 +1447,146 @@ void __ternary_store_t64(void *addr, t64_t value)
     *(t64_t *)addr = value;
 }
 
+/* Bulk array helpers: element-wise loops over the word kernels, shaped so the
+ * compiler can vectorize them. dst may be the same array as an input but must
+ * not otherwise overlap one. The t32 loops are also built per ISA (see
+ * ternary_runtime_opt.c); the 128-bit t64 kernels and the decode-based mul
+ * stay scalar.
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#define TERNARY_BULK_VECTORIZE __attribute__((optimize("tree-vectorize", "vect-cost-model=dynamic")))
+#else
+#define TERNARY_BULK_VECTORIZE
+#endif
+
+#define DEFINE_TERNARY_BULK_OPS(SUFFIX, TYPE, NAME, ATTR, ADD, SUB, NEG, TMIN, TMAX, TXOR, \
+                                TEQUIV, TMUX, DIGITS) \
+    ATTR void NAME(__ternary_add_t##SUFFIX##_n)(TYPE *dst, const TYPE *a, const TYPE *b, \
+                                                size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = ADD(a[i], b[i]); \
+    } \
+    ATTR void NAME(__ternary_sub_t##SUFFIX##_n)(TYPE *dst, const TYPE *a, const TYPE *b, \
+                                                size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = SUB(a[i], b[i]); \
+    } \
+    ATTR void NAME(__ternary_neg_t##SUFFIX##_n)(TYPE *dst, const TYPE *a, size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = NEG(a[i]); \
+    } \
+    ATTR void NAME(__ternary_tmin_t##SUFFIX##_n)(TYPE *dst, const TYPE *a, const TYPE *b, \
+                                                 size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = TMIN(a[i], b[i]); \
+    } \
+    ATTR void NAME(__ternary_tmax_t##SUFFIX##_n)(TYPE *dst, const TYPE *a, const TYPE *b, \
+                                                 size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = TMAX(a[i], b[i]); \
+    } \
+    ATTR void NAME(__ternary_txor_t##SUFFIX##_n)(TYPE *dst, const TYPE *a, const TYPE *b, \
+                                                 size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = TXOR(a[i], b[i]); \
+    } \
+    ATTR void NAME(__ternary_tequiv_t##SUFFIX##_n)(TYPE *dst, const TYPE *a, const TYPE *b, \
+                                                   size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = TEQUIV(a[i], b[i]); \
+    } \
+    ATTR void NAME(__ternary_tmux_t##SUFFIX##_n)(TYPE *dst, const TYPE *sel, const TYPE *neg, \
+                                                 const TYPE *zero, const TYPE *pos, size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = TMUX(sel[i], neg[i], zero[i], pos[i]); \
+    } \
+    ATTR void NAME(__ternary_cmp_t##SUFFIX##_n)(int *dst, const TYPE *a, const TYPE *b, \
+                                                size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) { \
+            TYPE da = DIGITS(a[i]); \
+            TYPE db = DIGITS(b[i]); \
+            dst[i] = (da > db) - (da < db); \
+        } \
+    } \
+    ATTR void NAME(__ternary_select_t##SUFFIX##_n)(TYPE *dst, const TERNARY_COND_T *cond, \
+                                                   const TYPE *true_val, \
+                                                   const TYPE *false_val, size_t n) \
+    { \
+        for (size_t i = 0; i < n; ++i) \
+            dst[i] = cond[i] ? true_val[i] : false_val[i]; \
+    }
+
+#define TERNARY_BULK_NAME(NAME) NAME
+#define TERNARY_BULK_NAME_DISPATCHED(NAME) TERNARY_DISPATCHED(NAME)
+
+DEFINE_TERNARY_BULK_OPS(32, t32_t, TERNARY_BULK_NAME_DISPATCHED, TERNARY_BULK_VECTORIZE,
+                        ternary_add_u64, ternary_sub_u64, ternary_neg_u64, ternary_tmin_u64,
+                        ternary_tmax_u64, ternary_txor_t32, ternary_tequiv_t32, ternary_tmux_u32,
+                        ternary_digits_u64)
+DEFINE_TERNARY_BULK_OPS(64, t64_t, TERNARY_BULK_NAME, ,
+                        ternary_add_u128, ternary_sub_u128, ternary_neg_u128, ternary_tmin_u128,
+                        ternary_tmax_u128, ternary_txor_t64, ternary_tequiv_t64, ternary_tmux_u64,
+                        ternary_digits_u128)
+
+#if defined(TERNARY_RUNTIME_DISPATCH) && defined(__x86_64__) && defined(__GNUC__)
+#define TERNARY_BULK_NAME_AVX2(NAME) NAME##_avx2
+#define TERNARY_BULK_NAME_AVX512(NAME) NAME##_avx512
+
+DEFINE_TERNARY_BULK_OPS(32, t32_t, TERNARY_BULK_NAME_AVX2,
+                        __attribute__((target("avx2"))) TERNARY_BULK_VECTORIZE,
+                        ternary_add_u64, ternary_sub_u64, ternary_neg_u64, ternary_tmin_u64,
+                        ternary_tmax_u64, ternary_txor_t32, ternary_tequiv_t32, ternary_tmux_u32,
+                        ternary_digits_u64)
+DEFINE_TERNARY_BULK_OPS(32, t32_t, TERNARY_BULK_NAME_AVX512,
+                        __attribute__((target("avx2,avx512f,avx512vl"))) TERNARY_BULK_VECTORIZE,
+                        ternary_add_u64, ternary_sub_u64, ternary_neg_u64, ternary_tmin_u64,
+                        ternary_tmax_u64, ternary_txor_t32, ternary_tequiv_t32, ternary_tmux_u32,
+                        ternary_digits_u64)
+
+#undef TERNARY_BULK_NAME_AVX2
+#undef TERNARY_BULK_NAME_AVX512
+#endif
+
+void __ternary_mul_t32_n(t32_t *dst, const t32_t *a, const t32_t *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = ternary_mul_u64(a[i], b[i]);
+}
+
+void __ternary_tmuladd_t32_n(t32_t *dst, const t32_t *a, const t32_t *b, const t32_t *c,
+                             size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = ternary_muladd_u64(a[i], b[i], c[i], 32);
+}
+
+void __ternary_mul_t64_n(t64_t *dst, const t64_t *a, const t64_t *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = ternary_mul_u128(a[i], b[i]);
+}
+
+void __ternary_tmuladd_t64_n(t64_t *dst, const t64_t *a, const t64_t *b, const t64_t *c,
+                             size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = ternary_muladd_u128(a[i], b[i], c[i], 64);
+}
+
+#undef TERNARY_BULK_NAME
+#undef TERNARY_BULK_NAME_DISPATCHED
+#undef DEFINE_TERNARY_BULK_OPS
+#undef TERNARY_BULK_VECTORIZE
+
 /* Vector operations - SIMD accelerated ternary computations */
 
 /* tv32_t operations (vector of 2 x t32_t) */
@@ -1,25 +1,274 @@
-#include "ternary_runtime.h"
+#include <stdlib.h>
+#include <string.h>
+#include "ternary_runtime_opt.h"
 
-// Optimized runtime with inline assembly (x86_64 example)
-// Fallback to C if not supported
+/* Optimized runtime layer (x86-64 first, portable fallback elsewhere).
+ * Its building block is conversion between the 2-bit packed form and the
+ * pos/neg two-mask form, where most tritwise kernels are plain boolean ops.
+ * When built with BMI2 each direction is a pext/pdep pair; otherwise the even
+ * bits are gathered and scattered with the usual shift-and-mask ladders.
+ *
+ * Exported helpers with ISA-specific variants are compiled with target
+ * attributes rather than global -m flags, so one binary runs everywhere; a
+ * resolver table filled at load time picks the variant.
+ */
 
-#ifdef __x86_64__
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define TERNARY_OPT_X86 1
+#endif
 
-int __ternary_add(int a, int b) {
-    int result;
-    __asm__ (
-        "add %1, %0"  // Placeholder: assume ternary add maps to add
-        : "=r"(result)
-        : "r"(a), "0"(b)
-    );
-    return result;
+#define TERNARY_OPT_EVEN_BITS 0x5555555555555555ULL
+#define TERNARY_OPT_ODD_BITS 0xAAAAAAAAAAAAAAAAULL
+
+#if defined(TERNARY_OPT_X86) && defined(__BMI2__)
+
+static uint32_t ternary_opt_gather(uint64_t word, uint64_t select)
+{
+    return (uint32_t)_pext_u64(word, select);
+}
+
+static uint64_t ternary_opt_scatter(uint32_t bits, uint64_t select)
+{
+    return _pdep_u64(bits, select);
 }
 
 #else
 
-// Fallback to C
-int __ternary_add(int a, int b) {
-    return a + b;  // Simplified
+/* Portable pext/pdep for the two fixed selectors used here. */
+static uint32_t ternary_opt_compress_even(uint64_t x)
+{
+    x &= TERNARY_OPT_EVEN_BITS;
+    x = (x | (x >> 1)) & 0x3333333333333333ULL;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    return (uint32_t)x;
+}
+
+static uint64_t ternary_opt_expand_even(uint32_t bits)
+{
+    uint64_t x = bits;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & TERNARY_OPT_EVEN_BITS;
+    return x;
+}
+
+static uint32_t ternary_opt_gather(uint64_t word, uint64_t select)
+{
+    return ternary_opt_compress_even(select == TERNARY_OPT_ODD_BITS ? word >> 1 : word);
+}
+
+static uint64_t ternary_opt_scatter(uint32_t bits, uint64_t select)
+{
+    uint64_t spread = ternary_opt_expand_even(bits);
+    return select == TERNARY_OPT_ODD_BITS ? spread << 1 : spread;
+}
+
+#endif
+
+static uint32_t ternary_opt_pos32(uint64_t packed)
+{
+    return ternary_opt_gather(packed, TERNARY_OPT_ODD_BITS);
+}
+
+static uint32_t ternary_opt_neg32(uint64_t packed)
+{
+    /* 00 is the only code with neither bit set. */
+    return ternary_opt_gather(~(packed | (packed >> 1)), TERNARY_OPT_EVEN_BITS);
+}
+
+static uint64_t ternary_opt_join32(uint32_t pos, uint32_t neg)
+{
+    return ternary_opt_scatter(pos, TERNARY_OPT_ODD_BITS) |
+           ternary_opt_scatter(~(pos | neg), TERNARY_OPT_EVEN_BITS);
+}
+
+ternary_masks32_t ternary_split_t32(t32_t packed)
+{
+    ternary_masks32_t masks;
+    masks.pos = ternary_opt_pos32(packed);
+    masks.neg = ternary_opt_neg32(packed);
+    return masks;
+}
+
+t32_t ternary_join_t32(ternary_masks32_t masks)
+{
+    return (t32_t)ternary_opt_join32(masks.pos, masks.neg);
+}
+
+ternary_masks64_t ternary_split_t64(t64_t packed)
+{
+    uint64_t lo = (uint64_t)packed;
+    uint64_t hi = (uint64_t)(packed >> 64);
+    ternary_masks64_t masks;
+    masks.pos = ((uint64_t)ternary_opt_pos32(hi) << 32) | ternary_opt_pos32(lo);
+    masks.neg = ((uint64_t)ternary_opt_neg32(hi) << 32) | ternary_opt_neg32(lo);
+    return masks;
+}
+
+t64_t ternary_join_t64(ternary_masks64_t masks)
+{
+    uint64_t lo = ternary_opt_join32((uint32_t)masks.pos, (uint32_t)masks.neg);
+    uint64_t hi = ternary_opt_join32((uint32_t)(masks.pos >> 32), (uint32_t)(masks.neg >> 32));
+    return ((t64_t)hi << 64) | lo;
+}
+
+#if defined(TERNARY_RUNTIME_DISPATCH) && defined(TERNARY_OPT_X86)
+/* Net trit sum as two hardware popcounts over the spread masks. */
+__attribute__((target("popcnt"))) static int ternary_tnet_t32_popcnt(t32_t a)
+{
+    uint64_t p = (uint64_t)a;
+    uint64_t plus = (p >> 1) & TERNARY_OPT_EVEN_BITS;
+    uint64_t minus = ~(p | (p >> 1)) & TERNARY_OPT_EVEN_BITS;
+    return __builtin_popcountll(plus) - __builtin_popcountll(minus);
+}
+
+__attribute__((target("popcnt"))) static int ternary_tnet_t64_popcnt(t64_t a)
+{
+    return ternary_tnet_t32_popcnt((t32_t)(uint64_t)a) +
+           ternary_tnet_t32_popcnt((t32_t)(uint64_t)(a >> 64));
+}
+
+/* Both halves in one vector: one vpopcntq per mask instead of four popcnts. */
+__attribute__((target("avx512vpopcntdq,avx512vl"))) static int ternary_tnet_t64_avx512(t64_t a)
+{
+    __m128i p = _mm_set_epi64x((long long)(uint64_t)(a >> 64), (long long)(uint64_t)a);
+    __m128i lsb = _mm_set1_epi64x((long long)TERNARY_OPT_EVEN_BITS);
+    __m128i high = _mm_srli_epi64(p, 1);
+    __m128i plus = _mm_and_si128(high, lsb);
+    __m128i minus = _mm_andnot_si128(_mm_or_si128(p, high), lsb);
+    __m128i net = _mm_sub_epi64(_mm_popcnt_epi64(plus), _mm_popcnt_epi64(minus));
+    return (int)(_mm_cvtsi128_si64(net) + _mm_extract_epi64(net, 1));
+}
+#endif
+
+typedef struct {
+    ternary_isa_t isa;
+#ifdef TERNARY_RUNTIME_DISPATCH
+    int (*tnet_t32)(t32_t);
+    int (*tnet_t64)(t64_t);
+#define TERNARY_BULK_ENTRY(NAME, PARAMS, ARGS) void(*NAME) PARAMS;
+    TERNARY_DISPATCHED_BULK_OPS(TERNARY_BULK_ENTRY)
+#undef TERNARY_BULK_ENTRY
+#endif
+} ternary_dispatch_table_t;
+
+/* Scalar entries are valid from the start, so helpers called before the
+ * load-time selection (e.g. from other constructors) still work.
+ */
+static const ternary_dispatch_table_t ternary_dispatch_scalar = {
+    TERNARY_ISA_SCALAR,
+#ifdef TERNARY_RUNTIME_DISPATCH
+    __ternary_tnet_t32_generic,
+    __ternary_tnet_t64_generic,
+#define TERNARY_BULK_ENTRY(NAME, PARAMS, ARGS) NAME##_generic,
+    TERNARY_DISPATCHED_BULK_OPS(TERNARY_BULK_ENTRY)
+#undef TERNARY_BULK_ENTRY
+#endif
+};
+
+static ternary_dispatch_table_t ternary_dispatch = ternary_dispatch_scalar;
+
+static const char *const ternary_isa_names[] = {
+    "scalar", "popcnt", "avx2", "avx512",
+};
+
+const char *ternary_runtime_isa_name(ternary_isa_t isa)
+{
+    if ((unsigned)isa >= sizeof(ternary_isa_names) / sizeof(ternary_isa_names[0]))
+        return "unknown";
+    return ternary_isa_names[isa];
+}
+
+static ternary_isa_t ternary_detect_isa(void)
+{
+#ifdef TERNARY_OPT_X86
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("popcnt"))
+        return TERNARY_ISA_SCALAR;
+    if (!__builtin_cpu_supports("avx2"))
+        return TERNARY_ISA_POPCNT;
+    if (!__builtin_cpu_supports("avx512vpopcntdq") || !__builtin_cpu_supports("avx512vl"))
+        return TERNARY_ISA_AVX2;
+    return TERNARY_ISA_AVX512;
+#else
+    return TERNARY_ISA_SCALAR;
+#endif
+}
+
+ternary_isa_t ternary_runtime_select_isa(ternary_isa_t requested)
+{
+    ternary_isa_t supported = ternary_detect_isa();
+    ternary_isa_t isa = requested < supported ? requested : supported;
+    ternary_dispatch_table_t table = ternary_dispatch_scalar;
+
+#ifdef TERNARY_OPT_X86
+#ifdef TERNARY_RUNTIME_DISPATCH
+    if (isa >= TERNARY_ISA_POPCNT) {
+        table.tnet_t32 = ternary_tnet_t32_popcnt;
+        table.tnet_t64 = ternary_tnet_t64_popcnt;
+    }
+#endif
+#ifdef TERNARY_RUNTIME_DISPATCH
+    if (isa >= TERNARY_ISA_AVX2) {
+#define TERNARY_BULK_ENTRY(NAME, PARAMS, ARGS) table.NAME = NAME##_avx2;
+        TERNARY_DISPATCHED_BULK_OPS(TERNARY_BULK_ENTRY)
+#undef TERNARY_BULK_ENTRY
+    }
+    if (isa >= TERNARY_ISA_AVX512) {
+        table.tnet_t64 = ternary_tnet_t64_avx512;
+#define TERNARY_BULK_ENTRY(NAME, PARAMS, ARGS) table.NAME = NAME##_avx512;
+        TERNARY_DISPATCHED_BULK_OPS(TERNARY_BULK_ENTRY)
+#undef TERNARY_BULK_ENTRY
+    }
+#endif
+#endif
+
+    table.isa = isa;
+    ternary_dispatch = table;
+    return isa;
+}
+
+ternary_isa_t ternary_runtime_isa(void)
+{
+    return ternary_dispatch.isa;
+}
+
+__attribute__((constructor)) static void ternary_runtime_dispatch_init(void)
+{
+    ternary_isa_t requested = TERNARY_ISA_AVX512;
+    const char *env = getenv("TERNARY_RUNTIME_ISA");
+
+    if (env) {
+        for (unsigned i = 0; i < sizeof(ternary_isa_names) / sizeof(ternary_isa_names[0]); ++i) {
+            if (strcmp(env, ternary_isa_names[i]) == 0)
+                requested = (ternary_isa_t)i;
+        }
+    }
+    ternary_runtime_select_isa(requested);
+}
+
+#ifdef TERNARY_RUNTIME_DISPATCH
+int __ternary_tnet_t32(t32_t a)
+{
+    return ternary_dispatch.tnet_t32(a);
+}
+
+int __ternary_tnet_t64(t64_t a)
+{
+    return ternary_dispatch.tnet_t64(a);
 }
 
-#endif
\ No newline at end of file
+#define TERNARY_BULK_ENTRY(NAME, PARAMS, ARGS) \
+    void NAME PARAMS \
+    { \
+        ternary_dispatch.NAME ARGS; \
+    }
+TERNARY_DISPATCHED_BULK_OPS(TERNARY_BULK_ENTRY)
+#undef TERNARY_BULK_ENTRY
+#endif
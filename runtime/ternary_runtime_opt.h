@@ -0,0 +1,86 @@
+#ifndef TERNARY_RUNTIME_OPT_H
+#define TERNARY_RUNTIME_OPT_H
+
+#include <stdint.h>
+#include "ternary_runtime.h"
+
+/* Internal interface of the optimized runtime layer (runtime/ternary_runtime_opt.c).
+ * These are not part of the helper ABI.
+ */
+
+/* Two-mask form of a packed word: bit i of pos/neg is set when trit i is +1/-1.
+ * Reserved 11 codes count as +1. When joining, pos and neg are expected to be
+ * disjoint; a trit set in both comes back as +1.
+ */
+typedef struct {
+    uint32_t pos;
+    uint32_t neg;
+} ternary_masks32_t;
+
+typedef struct {
+    uint64_t pos;
+    uint64_t neg;
+} ternary_masks64_t;
+
+ternary_masks32_t ternary_split_t32(t32_t packed);
+t32_t ternary_join_t32(ternary_masks32_t masks);
+ternary_masks64_t ternary_split_t64(t64_t packed);
+t64_t ternary_join_t64(ternary_masks64_t masks);
+
+/* Variant levels; each level implies the features of the ones below it. */
+typedef enum {
+    TERNARY_ISA_SCALAR = 0,
+    TERNARY_ISA_POPCNT,
+    TERNARY_ISA_AVX2,
+    TERNARY_ISA_AVX512
+} ternary_isa_t;
+
+/* The level is picked once at load time from CPUID, capped by the
+ * TERNARY_RUNTIME_ISA environment variable (scalar, popcnt, avx2, avx512).
+ * ternary_runtime_select_isa re-selects at run time, never above what the
+ * CPU supports, and returns the level actually in use.
+ */
+ternary_isa_t ternary_runtime_isa(void);
+ternary_isa_t ternary_runtime_select_isa(ternary_isa_t requested);
+const char *ternary_runtime_isa_name(ternary_isa_t isa);
+
+#ifdef TERNARY_RUNTIME_DISPATCH
+/* Portable bodies of the dispatched helpers, defined in ternary_runtime.c. */
+int __ternary_tnet_t32_generic(t32_t a);
+int __ternary_tnet_t64_generic(t64_t a);
+
+/* Bulk helpers with _generic, _avx2 and _avx512 bodies in ternary_runtime.c:
+ * X(name, parameter list, argument list).
+ */
+#define TERNARY_DISPATCHED_BULK_OPS(X) \
+    X(__ternary_add_t32_n, (t32_t *dst, const t32_t *a, const t32_t *b, size_t n), \
+      (dst, a, b, n)) \
+    X(__ternary_sub_t32_n, (t32_t *dst, const t32_t *a, const t32_t *b, size_t n), \
+      (dst, a, b, n)) \
+    X(__ternary_neg_t32_n, (t32_t *dst, const t32_t *a, size_t n), (dst, a, n)) \
+    X(__ternary_tmin_t32_n, (t32_t *dst, const t32_t *a, const t32_t *b, size_t n), \
+      (dst, a, b, n)) \
+    X(__ternary_tmax_t32_n, (t32_t *dst, const t32_t *a, const t32_t *b, size_t n), \
+      (dst, a, b, n)) \
+    X(__ternary_txor_t32_n, (t32_t *dst, const t32_t *a, const t32_t *b, size_t n), \
+      (dst, a, b, n)) \
+    X(__ternary_tequiv_t32_n, (t32_t *dst, const t32_t *a, const t32_t *b, size_t n), \
+      (dst, a, b, n)) \
+    X(__ternary_tmux_t32_n, (t32_t *dst, const t32_t *sel, const t32_t *neg, \
+                             const t32_t *zero, const t32_t *pos, size_t n), \
+      (dst, sel, neg, zero, pos, n)) \
+    X(__ternary_cmp_t32_n, (int *dst, const t32_t *a, const t32_t *b, size_t n), \
+      (dst, a, b, n)) \
+    X(__ternary_select_t32_n, (t32_t *dst, const TERNARY_COND_T *cond, \
+                               const t32_t *true_val, const t32_t *false_val, size_t n), \
+      (dst, cond, true_val, false_val, n))
+
+#define TERNARY_DECLARE_BULK_VARIANTS(NAME, PARAMS, ARGS) \
+    void NAME##_generic PARAMS; \
+    void NAME##_avx2 PARAMS; \
+    void NAME##_avx512 PARAMS;
+TERNARY_DISPATCHED_BULK_OPS(TERNARY_DECLARE_BULK_VARIANTS)
+#undef TERNARY_DECLARE_BULK_VARIANTS
+#endif
+
+#endif /* TERNARY_RUNTIME_OPT_H */
@@ -111,6 +111,71 @@ static uint64_t ternary_encode_u64(int64_t value, unsigned trit_count)
     return packed;
 }
 
+/* Packed words compare like their values once reserved 11 codes are folded to
+ * +1, because the 00/01/10 codes are monotone in the trit they encode. */
+static uint64_t ternary_compare_key_u64(uint64_t packed)
+{
+    return packed & ~(packed & (packed >> 1) & 0x5555555555555555ULL);
+}
+
+static unsigned __int128 ternary_compare_key_u128(unsigned __int128 packed)
+{
+    const unsigned __int128 lsb = ((unsigned __int128)0x5555555555555555ULL << 64) |
+                                  0x5555555555555555ULL;
+    return packed & ~(packed & (packed >> 1) & lsb);
+}
+
+/* One bit per trit at the low bit of its field: +1 (10 or reserved 11) and -1 (00). */
+static uint64_t ternary_plus_mask_u64(uint64_t packed)
+{
+    return (packed >> 1) & 0x5555555555555555ULL;
+}
+
+static uint64_t ternary_minus_mask_u64(uint64_t packed)
+{
+    return ~(packed | (packed >> 1)) & 0x5555555555555555ULL;
+}
+
+static unsigned __int128 ternary_plus_mask_u128(unsigned __int128 packed)
+{
+    return ((unsigned __int128)ternary_plus_mask_u64((uint64_t)(packed >> 64)) << 64) |
+           ternary_plus_mask_u64((uint64_t)packed);
+}
+
+static unsigned __int128 ternary_minus_mask_u128(unsigned __int128 packed)
+{
+    return ((unsigned __int128)ternary_minus_mask_u64((uint64_t)(packed >> 64)) << 64) |
+           ternary_minus_mask_u64((uint64_t)packed);
+}
+
+/* Net trit sum: count(+1) - count(-1). */
+static int ternary_tnet_u64(uint64_t packed)
+{
+    return __builtin_popcountll(ternary_plus_mask_u64(packed)) -
+           __builtin_popcountll(ternary_minus_mask_u64(packed));
+}
+
+static int ternary_tnet_u128(unsigned __int128 packed)
+{
+    return ternary_tnet_u64((uint64_t)(packed >> 64)) + ternary_tnet_u64((uint64_t)packed);
+}
+
+/* Sign of the most significant non-zero trit: the masks are disjoint, so the
+ * larger one owns that trit. */
+static int ternary_sign_u64(uint64_t packed)
+{
+    uint64_t plus = ternary_plus_mask_u64(packed);
+    uint64_t minus = ternary_minus_mask_u64(packed);
+    return (plus > minus) - (plus < minus);
+}
+
+static int ternary_sign_u128(unsigned __int128 packed)
+{
+    unsigned __int128 plus = ternary_plus_mask_u128(packed);
+    unsigned __int128 minus = ternary_minus_mask_u128(packed);
+    return (plus > minus) - (plus < minus);
+}
+
 static int ternary_get_trit_u64(uint64_t packed, unsigned idx)
 {
     unsigned bits = (unsigned)((packed >> (2U * idx)) & 0x3U);
@@ -305,14 +370,16 @@ static t128_t ternary_encode_t128(int64_t value, unsigned trit_count)
     return packed;
 }
 
-static int ternary_sign_t128(t128_t packed, unsigned trit_count)
+static int ternary_tnet_t128(t128_t packed)
 {
-    for (int i = (int)trit_count - 1; i >= 0; --i) {
-        int trit = ternary_get_trit_t128(packed, (unsigned)i);
-        if (trit != 0)
-            return trit;
-    }
-    return 0;
+    return ternary_tnet_u128((unsigned __int128)(packed >> 128)) +
+           ternary_tnet_u128((unsigned __int128)packed);
+}
+
+static int ternary_sign_t128(t128_t packed)
+{
+    int high = ternary_sign_u128((unsigned __int128)(packed >> 128));
+    return high != 0 ? high : ternary_sign_u128((unsigned __int128)packed);
 }
 
 static t128_t ternary_tritwise_op_t128(t128_t a, t128_t b, unsigned trit_count, int op)
@@ -457,8 +524,8 @@ static t128_t ternary_implication_t128(t128_t antecedent, t128_t consequent, uns
 
 static t128_t ternary_tequiv_t128(t128_t a, t128_t b)
 {
-    int sign_a = ternary_sign_t128(a, 128);
-    int sign_b = ternary_sign_t128(b, 128);
+    int sign_a = ternary_sign_t128(a);
+    int sign_b = ternary_sign_t128(b);
     int trit = 0;
     if (sign_a == 0 || sign_b == 0)
         trit = 0;
@@ -471,8 +538,8 @@ static t128_t ternary_tequiv_t128(t128_t a, t128_t b)
 
 static t128_t ternary_txor_t128(t128_t a, t128_t b)
 {
-    int sign_a = ternary_sign_t128(a, 128);
-    int sign_b = ternary_sign_t128(b, 128);
+    int sign_a = ternary_sign_t128(a);
+    int sign_b = ternary_sign_t128(b);
     int trit = 0;
     if (sign_a == sign_b && sign_a != 0)
         trit = -1;
@@ -487,7 +554,7 @@ static t128_t ternary_txor_t128(t128_t a, t128_t b)
 
 static t128_t ternary_tmux_u128(t128_t sel, t128_t neg, t128_t zero, t128_t pos)
 {
-    int cond = ternary_sign_t128(sel, 128);
+    int cond = ternary_sign_t128(sel);
     if (cond < 0)
         return neg;
     if (cond > 0)
@@ -630,26 +697,15 @@ static int ternary_branch_target(TERNARY_COND_T cond, int neg_target, int zero_t
     return zero_target;
 }
 
-static int ternary_signjmp_u64(uint64_t packed, unsigned trit_count,
-                               int neg_target, int zero_target, int pos_target)
+static int ternary_signjmp_u64(uint64_t packed, int neg_target, int zero_target, int pos_target)
 {
-    int64_t value = ternary_decode_u64(packed, trit_count);
-    if (value < 0)
-        return neg_target;
-    if (value > 0)
-        return pos_target;
-    return zero_target;
+    return ternary_branch_target(ternary_sign_u64(packed), neg_target, zero_target, pos_target);
 }
 
-static int ternary_signjmp_u128(unsigned __int128 packed, unsigned trit_count,
-                                int neg_target, int zero_target, int pos_target)
+static int ternary_signjmp_u128(unsigned __int128 packed, int neg_target, int zero_target,
+                                int pos_target)
 {
-    int64_t value = ternary_decode_u128(packed, trit_count);
-    if (value < 0)
-        return neg_target;
-    if (value > 0)
-        return pos_target;
-    return zero_target;
+    return ternary_branch_target(ternary_sign_u128(packed), neg_target, zero_target, pos_target);
 }
 
 static uint64_t ternary_implication_u64(uint64_t a, uint64_t b, unsigned trit_count)
@@ -1118,13 +1174,9 @@ int64_t __ternary_tt2b_t32(t32_t v)
 
 int __ternary_cmp_t32(t32_t a, t32_t b)
 {
-    int64_t va = ternary_decode_u64(a, 32);
-    int64_t vb = ternary_decode_u64(b, 32);
-    if (va < vb)
-        return -1;
-    if (va > vb)
-        return 1;
-    return 0;
+    uint64_t ka = ternary_compare_key_u64(a);
+    uint64_t kb = ternary_compare_key_u64(b);
+    return (ka > kb) - (ka < kb);
 }
 
 /* t64 helpers */
@@ -1281,13 +1333,9 @@ int64_t __ternary_tt2b_t64(t64_t v)
 
 int __ternary_cmp_t64(t64_t a, t64_t b)
 {
-    int64_t va = ternary_decode_u128(a, 64);
-    int64_t vb = ternary_decode_u128(b, 64);
-    if (va < vb)
-        return -1;
-    if (va > vb)
-        return 1;
-    return 0;
+    unsigned __int128 ka = ternary_compare_key_u128(a);
+    unsigned __int128 kb = ternary_compare_key_u128(b);
+    return (ka > kb) - (ka < kb);
 }
 
 #if defined(__BITINT_MAXWIDTH__) && __BITINT_MAXWIDTH__ >= 256 && !defined(__cplusplus)
@@ -1357,7 +1405,7 @@ t128_t __ternary_txor_t128(t128_t a, t128_t b)
 
 int __ternary_tnet_t128(t128_t a)
 {
-    return (int)ternary_decode_t128(a, 128);
+    return ternary_tnet_t128(a);
 }
 
 t128_t __ternary_tmux_t128(t128_t sel, t128_t neg, t128_t zero, t128_t pos)
@@ -1373,12 +1421,22 @@ int __ternary_tbranch(TERNARY_COND_T cond, int neg_target, int zero_target, int
 
 int __ternary_tsignjmp_t32(t32_t reg, int neg_target, int zero_target, int pos_target)
 {
-    return ternary_signjmp_u64(reg, 32, neg_target, zero_target, pos_target);
+    return ternary_signjmp_u64(reg, neg_target, zero_target, pos_target);
 }
 
 int __ternary_tsignjmp_t64(t64_t reg, int neg_target, int zero_target, int pos_target)
 {
-    return ternary_signjmp_u128(reg, 64, neg_target, zero_target, pos_target);
+    return ternary_signjmp_u128(reg, neg_target, zero_target, pos_target);
+}
+
+int __ternary_tnet_t32(t32_t a)
+{
+    return ternary_tnet_u64(a);
+}
+
+int __ternary_tnet_t64(t64_t a)
+{
+    return ternary_tnet_u128(a);
 }
 
 #undef __ternary_add
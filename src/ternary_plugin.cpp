@@ -1,6 +1,10 @@
+#include <algorithm>
 #include <map>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include <cstdio>
 
 #include <gcc-plugin.h>
@@ -9,8 +13,17 @@
 #include <gimple.h>
 #include <gimple-iterator.h>
 #include <gimple-pretty-print.h>
+#include <gimple-ssa.h>
+#include <tree-ssanames.h>
 #include <tree-pass.h>
+#include <tree-cfg.h>
+#include <cfghooks.h>
+#include <dominance.h>
+#include <optabs-query.h>
+#include <target.h>
 #include <basic-block.h>
+#include <cfgloop.h>
+#include <cfgcleanup.h>
 #include <context.h>
 #include <c-family/c-common.h>
 #include <diagnostic-core.h>
@@ -77,10 +90,46 @@ static bool opt_version = false;
 static bool opt_selftest = false;
 static bool opt_trace = false;
 static bool opt_dump_gimple = false;
+static unsigned opt_inline = 0;
+static bool opt_late = false;
+static bool opt_region = false;
 static std::string opt_prefix = "__ternary";
 
+// -select=<policy>: which selects without a ternary operand -lower turns into
+// select helper calls. Selects on ternary values are always lowered.
+enum ternary_select_policy
+{
+    TERNARY_SELECT_TERNARY_ONLY, // keep every other COND_EXPR native
+    TERNARY_SELECT_PROFITABLE,   // also those the target cannot conditionally move
+    TERNARY_SELECT_ALL           // every integer and float select
+};
+
+static ternary_select_policy opt_select = TERNARY_SELECT_TERNARY_ONLY;
+
+// Helper classes -inline=<list|all> expands in place instead of calling.
+enum ternary_inline_class
+{
+    TERNARY_INLINE_NEG = 1U << 0,    // neg, not, tnot
+    TERNARY_INLINE_MINMAX = 1U << 1, // and/or as tmin/tmax
+    TERNARY_INLINE_SELECT = 1U << 2, // selects producing ternary values
+    TERNARY_INLINE_SHIFT = 1U << 3,  // shifts and rotates by a constant
+    TERNARY_INLINE_CMP = 1U << 4,    // comparisons and the eq..ge builtins
+    TERNARY_INLINE_ALL = (1U << 5) - 1
+};
+
+static const struct
+{
+    const char *name;
+    unsigned mask;
+} ternary_inline_classes[] = {
+    {"neg", TERNARY_INLINE_NEG},       {"minmax", TERNARY_INLINE_MINMAX},
+    {"select", TERNARY_INLINE_SELECT}, {"shift", TERNARY_INLINE_SHIFT},
+    {"cmp", TERNARY_INLINE_CMP},       {"all", TERNARY_INLINE_ALL},
+};
+
 static tree get_cmp_decl(tree result_type);
 static tree get_shift_decl(const char *name, tree result_type);
+static tree get_tround_decl(tree result_type);
 static tree get_conv_to_ternary_decl(const char *name, tree result_type, tree arg_type);
 static tree get_conv_from_ternary_decl(const char *name, tree result_type, tree arg_type);
 static tree get_select_decl(tree result_type, tree cond_type);
@@ -90,16 +139,60 @@ static tree create_selftest_type(unsigned trit_count);
 static unsigned long ternary_count = 0;
 static unsigned long lowered_count = 0;
 static unsigned long surviving_count = 0;
+static unsigned long rewrite_count = 0;
+static unsigned long conversion_count = 0;
 
-static std::map<unsigned, tree> select_decl_cache;
+static std::map<std::tuple<std::string, tree, tree>, tree> helper_decl_registry;
 static std::map<unsigned, unsigned> ternary_type_uids;
 static std::map<unsigned, unsigned> ternary_vector_type_uids;
 
+// The __builtin_ternary_* entry points the pass lowers: X(ID, "name suffix").
+#define TERNARY_BUILTINS(X) \
+    X(ADD, "add") X(SUB, "sub") X(MUL, "mul") X(DIV, "div") X(MOD, "mod") X(NEG, "neg") \
+    X(CMP, "cmp") X(EQ, "eq") X(NE, "ne") X(LT, "lt") X(LE, "le") X(GT, "gt") X(GE, "ge") \
+    X(CMPLT, "cmplt") X(CMPEQ, "cmpeq") X(CMPGT, "cmpgt") X(CMPNEQ, "cmpneq") \
+    X(CMPLT_T64, "cmplt_t64") X(CMPEQ_T64, "cmpeq_t64") X(CMPGT_T64, "cmpgt_t64") \
+    X(CMPNEQ_T64, "cmpneq_t64") \
+    X(NOT, "not") X(AND, "and") X(OR, "or") X(XOR, "xor") X(SELECT, "select") \
+    X(SHL, "shl") X(SHR, "shr") X(ROL, "rol") X(ROR, "ror") \
+    X(TB2T, "tb2t") X(TT2B, "tt2b") X(T2F, "t2f") X(F2T, "f2t") \
+    X(LOAD_T32, "load_t32") X(STORE_T32, "store_t32") X(LOAD_T64, "load_t64") X(STORE_T64, "store_t64")
+
+enum ternary_builtin {
+    TERNARY_BUILTIN_NONE,
+#define TERNARY_BUILTIN_ENUM(ID, NAME) TERNARY_BUILTIN_##ID,
+    TERNARY_BUILTINS(TERNARY_BUILTIN_ENUM)
+#undef TERNARY_BUILTIN_ENUM
+};
+
+// Keyed by the interned IDENTIFIER_NODE of each name, so classifying a call
+// is one pointer hash instead of a strcmp per builtin. Filled once at
+// PLUGIN_START_UNIT.
+static std::unordered_map<tree, ternary_builtin> ternary_builtin_table;
+
 static tree lower_cond_expr_tree(tree expr, gimple_stmt_iterator *gsi);
 static tree lower_cond_expr_in_tree(tree expr, gimple_stmt_iterator *gsi);
 static bool tree_has_cond_expr(tree expr);
 static tree build_cmp_call(tree arg1, tree arg2, gimple_stmt_iterator *gsi);
+static bool ternary_cmp_can_inline(tree arg1, tree arg2);
+static tree ternary_cmp_operand(tree op);
+static bool ternary_inline_type_p(tree type);
+static tree ternary_trit_lsb(tree type);
+static tree ternary_emit_op(gimple_stmt_iterator *gsi, tree type, enum tree_code code,
+                            tree op1, tree op2);
+static bool ternary_expand_inline(enum tree_code code, tree lhs, tree arg1, tree arg2,
+                                  gimple_stmt_iterator *gsi);
+static bool ternary_select_can_inline(tree result_type, tree cond);
+static tree ternary_select_flag(tree cond, gimple_stmt_iterator *gsi);
+static tree ternary_truth_flag(tree cond, gimple_stmt_iterator *gsi);
+static bool ternary_expand_const_shift(const char *op, tree lhs, tree value, tree count,
+                                       gimple_stmt_iterator *gsi);
 static std::string build_helper_name(const char *base);
+static tree get_helper_fn_decl(const char *name, tree fn_type);
+static tree ternary_registered_decl(const char *helper, tree type, tree aux);
+static tree ternary_register_decl(const char *helper, tree type, tree aux, tree decl);
+static tree ternary_make_temp(tree type, const char *name);
+static bool ternary_order_code_p(enum tree_code code);
 
 static std::string read_version_file()
 {
@@ -166,7 +259,9 @@ static void maybe_dump_stmt(gimple *stmt)
 
 static bool get_ternary_type_trits(tree type, unsigned *trit_count)
 {
-    if (!type)
+    // Ternary types are always integers (t128_t may be a _BitInt); everything
+    // else is rejected before the uid lookup.
+    if (!type || !INTEGRAL_TYPE_P(type))
         return false;
 
     const unsigned uid = TYPE_UID(type);
@@ -252,7 +347,7 @@ static bool get_ternary_vector_type_trits(tree type, unsigned *element_trit_coun
 }
 
 static bool ternary_pack_constant(tree value, tree type, tree *out);
-static bool ternary_unpack_constant(tree value, tree type, int64_t *out);
+static bool ternary_unpack_constant(tree value, tree type, widest_int *out);
 
 static inline bool is_cond_stmt(const gimple *stmt)
 {
@@ -264,6 +359,24 @@ static inline bool is_return_stmt(const gimple *stmt)
     return stmt && stmt->code == GIMPLE_RETURN;
 }
 
+// Whether -select lets a select producing RESULT_TYPE on COND become a helper
+// call. Native COND_EXPRs on plain scalars feed if-conversion and conditional
+// moves, which a call would defeat.
+static bool ternary_select_lowered_p(tree result_type, tree cond)
+{
+    tree cond_type = COMPARISON_CLASS_P(cond) ? TREE_TYPE(TREE_OPERAND(cond, 0)) : TREE_TYPE(cond);
+    if (get_ternary_type_trits(result_type, nullptr) || get_ternary_type_trits(cond_type, nullptr))
+        return true;
+    switch (opt_select) {
+    case TERNARY_SELECT_ALL:
+        return true;
+    case TERNARY_SELECT_PROFITABLE:
+        return !can_conditionally_move_p(TYPE_MODE(result_type));
+    default:
+        return false;
+    }
+}
+
 static tree lower_cond_expr_tree(tree expr, gimple_stmt_iterator *gsi)
 {
     if (!expr || TREE_CODE(expr) != COND_EXPR)
@@ -295,7 +408,7 @@ static tree lower_cond_expr_tree(tree expr, gimple_stmt_iterator *gsi)
         bool cond_known = false;
         bool cond_zero = false;
         if (get_ternary_type_trits(TREE_TYPE(cond), nullptr)) {
-            int64_t logical = 0;
+            widest_int logical;
             if (ternary_unpack_constant(cond, TREE_TYPE(cond), &logical)) {
                 cond_known = true;
                 cond_zero = (logical == 0);
@@ -312,21 +425,18 @@ static tree lower_cond_expr_tree(tree expr, gimple_stmt_iterator *gsi)
         return true_val;
 
     tree result_type = TREE_TYPE(expr);
+    if (!ternary_select_lowered_p(result_type, cond)) {
+        COND_EXPR_COND(expr) = cond;
+        COND_EXPR_THEN(expr) = true_val;
+        COND_EXPR_ELSE(expr) = false_val;
+        return expr;
+    }
+
     tree cond_arg = cond;
     tree cond_type = TREE_TYPE(cond);
-    unsigned cond_trits = 0;
-    if (get_ternary_type_trits(cond_type, &cond_trits)) {
-        tree conv_decl = get_conv_from_ternary_decl("tt2b",
-                                                    long_long_integer_type_node,
-                                                    cond_type);
-        if (!conv_decl)
-            return expr;
-
-        tree tmp_cond = create_tmp_var(long_long_integer_type_node, "ternary_cond");
-        gcall *conv_call = gimple_build_call(conv_decl, 1, cond);
-        gimple_call_set_lhs(conv_call, tmp_cond);
-        gsi_insert_before(gsi, conv_call, GSI_SAME_STMT);
-        cond_arg = tmp_cond;
+    if (get_ternary_type_trits(cond_type, nullptr)) {
+        tree flag = ternary_truth_flag(cond, gsi);
+        cond_arg = ternary_emit_op(gsi, long_long_integer_type_node, NOP_EXPR, flag, NULL_TREE);
     } else if (!types_compatible_p(cond_type, long_long_integer_type_node)) {
         cond_arg = fold_convert(long_long_integer_type_node, cond);
     }
@@ -335,7 +445,7 @@ static tree lower_cond_expr_tree(tree expr, gimple_stmt_iterator *gsi)
     if (!decl)
         return expr;
 
-    tree tmp = create_tmp_var(result_type, "ternary_sel");
+    tree tmp = ternary_make_temp(result_type, "ternary_sel");
     gcall *call = gimple_build_call(decl, 3, cond_arg, true_val, false_val);
     gimple_call_set_lhs(call, tmp);
     gsi_insert_before(gsi, call, GSI_SAME_STMT);
@@ -408,6 +518,77 @@ static std::string build_helper_name(const char *base)
     return opt_prefix + "_" + base;
 }
 
+// Runtime helpers are pure functions of their arguments: they touch no memory
+// the caller can see, never throw and never call back into this unit. One
+// shared const/nothrow/leaf decl per helper lets CSE, LIM and DCE treat the
+// lowered calls like the operations they replace. The memory builtins are
+// lowered to plain MEM_REFs and never come through here.
+static tree get_helper_fn_decl(const char *name, tree fn_type)
+{
+    tree decl = build_fn_decl(name, fn_type);
+    TREE_PUBLIC(decl) = 1;
+    DECL_EXTERNAL(decl) = 1;
+    DECL_ARTIFICIAL(decl) = 1;
+    set_call_expr_flags(decl, ECF_CONST | ECF_NOTHROW | ECF_LEAF);
+    return decl;
+}
+
+// The get_*_decl builders intern their result by (helper, type, auxiliary
+// type), so every statement after the first one that needs a helper costs a
+// single lookup instead of a name and a function type, and each helper gets
+// one decl per translation unit. get_helper_fn_decl is only called on a miss.
+static tree ternary_registered_decl(const char *helper, tree type, tree aux)
+{
+    const auto it = helper_decl_registry.find(std::make_tuple(std::string(helper), type, aux));
+    return it == helper_decl_registry.end() ? NULL_TREE : it->second;
+}
+
+static tree ternary_register_decl(const char *helper, tree type, tree aux, tree decl)
+{
+    if (decl)
+        helper_decl_registry.emplace(std::make_tuple(std::string(helper), type, aux), decl);
+    return decl;
+}
+
+// The unsuffixed helper a __builtin_ternary_* call on a plain integer of
+// ARG_TYPE lowers to, interned like the typed ones.
+static tree get_builtin_helper_decl(const char *name, tree arg_type, tree fn_type)
+{
+    const std::string key = std::string("builtin_") + name;
+    if (tree decl = ternary_registered_decl(key.c_str(), arg_type, NULL_TREE))
+        return decl;
+    std::string helper = build_helper_name(name);
+    return ternary_register_decl(key.c_str(), arg_type, NULL_TREE,
+                                 get_helper_fn_decl(helper.c_str(), fn_type));
+}
+
+static void ternary_init_builtin_table()
+{
+    if (!ternary_builtin_table.empty())
+        return;
+#define TERNARY_BUILTIN_ENTRY(ID, NAME) \
+    ternary_builtin_table.emplace(get_identifier("__builtin_ternary_" NAME), TERNARY_BUILTIN_##ID);
+    TERNARY_BUILTINS(TERNARY_BUILTIN_ENTRY)
+#undef TERNARY_BUILTIN_ENTRY
+}
+
+static ternary_builtin ternary_builtin_kind(tree fndecl)
+{
+    if (!fndecl || !DECL_NAME(fndecl))
+        return TERNARY_BUILTIN_NONE;
+    const auto it = ternary_builtin_table.find(DECL_NAME(fndecl));
+    return it == ternary_builtin_table.end() ? TERNARY_BUILTIN_NONE : it->second;
+}
+
+// The late instance runs on SSA form, where new values must be SSA names; the
+// early instance runs before SSA and uses named temporaries.
+static tree ternary_make_temp(tree type, const char *name)
+{
+    if (gimple_in_ssa_p(cfun))
+        return make_ssa_name(type);
+    return create_tmp_var(type, name);
+}
+
 static tree build_cmp_call(tree arg1, tree arg2, gimple_stmt_iterator *gsi)
 {
     if (!arg1 || !arg2)
@@ -421,6 +602,8 @@ static tree build_cmp_call(tree arg1, tree arg2, gimple_stmt_iterator *gsi)
         return NULL_TREE;
 
     tree decl = get_cmp_decl(arg1_type);
+    arg1 = ternary_cmp_operand(arg1);
+    arg2 = ternary_cmp_operand(arg2);
     if (!decl)
     {
         if (opt_warn) {
@@ -432,47 +615,378 @@ static tree build_cmp_call(tree arg1, tree arg2, gimple_stmt_iterator *gsi)
         return NULL_TREE;
     }
 
-    tree tmp = create_tmp_var(integer_type_node, "ternary_cmp");
+    tree tmp = ternary_make_temp(integer_type_node, "ternary_cmp");
     gcall *call = gimple_build_call(decl, 2, arg1, arg2);
     gimple_call_set_lhs(call, tmp);
     gsi_insert_before(gsi, call, GSI_SAME_STMT);
     return tmp;
 }
 
-static bool ternary_value_fits_trits(int64_t value, unsigned trit_count)
+// The 00/01/10 trit codes are monotone, so an unsigned compare of two packed
+// words already gives the balanced-ternary order. With -inline=cmp the original
+// comparison is kept instead of being routed through cmp_tN; this assumes the
+// operands never carry the reserved 11 code, which no helper or literal emits.
+// -late implies this so the SSA optimizers see the comparisons.
+static bool ternary_cmp_can_inline(tree arg1, tree arg2)
 {
-    if (trit_count >= 40)
-        return true;
+    if (!((opt_inline & TERNARY_INLINE_CMP) || opt_late) || !arg1 || !arg2)
+        return false;
 
-    int64_t pow3 = 1;
-    for (unsigned i = 0; i < trit_count; ++i) {
-        if (pow3 > (INT64_MAX / 3))
-            return true;
-        pow3 *= 3;
+    tree arg1_type = TREE_TYPE(arg1);
+    if (!ternary_inline_type_p(arg1_type))
+        return false;
+    if (!types_compatible_p(arg1_type, TREE_TYPE(arg2)))
+        return false;
+    // Literals are compared in packed form, so they must pack.
+    tree packed = NULL_TREE;
+    if (TREE_CODE(arg1) == INTEGER_CST && !ternary_pack_constant(arg1, arg1_type, &packed))
+        return false;
+    if (TREE_CODE(arg2) == INTEGER_CST && !ternary_pack_constant(arg2, arg1_type, &packed))
+        return false;
+    return true;
+}
+
+// Comparison operands as the packed word: literals are still logical values.
+static tree ternary_cmp_operand(tree op)
+{
+    tree packed = NULL_TREE;
+    if (op && TREE_CODE(op) == INTEGER_CST && ternary_pack_constant(op, TREE_TYPE(op), &packed))
+        return packed;
+    return op;
+}
+
+// Inline expansions operate on the packed word itself, so its mode has to be
+// one the target does arithmetic in. t128 (256 bits) keeps its helpers.
+static bool ternary_inline_type_p(tree type)
+{
+    scalar_int_mode mode;
+    return get_ternary_type_trits(type, nullptr) && TYPE_UNSIGNED(type) &&
+           is_a<scalar_int_mode>(TYPE_MODE(type), &mode) &&
+           targetm.scalar_mode_supported_p(mode);
+}
+
+// 01 in every trit field: the packed zero.
+static tree ternary_trit_lsb(tree type)
+{
+    const unsigned prec = TYPE_PRECISION(type);
+    return wide_int_to_tree(type, wi::udiv_trunc(wi::minus_one(prec), wi::uhwi(3, prec)));
+}
+
+// Emits TMP = OP1 CODE OP2 (or CODE OP1 when OP2 is null) before GSI.
+static tree ternary_emit_op(gimple_stmt_iterator *gsi, tree type, enum tree_code code,
+                            tree op1, tree op2)
+{
+    tree tmp = ternary_make_temp(type, "ternary_swar");
+    gimple *g = op2 ? gimple_build_assign(tmp, code, op1, op2)
+                    : gimple_build_assign(tmp, code, op1);
+    gimple_set_location(g, gimple_location(gsi_stmt(*gsi)));
+    gsi_insert_before(gsi, g, GSI_SAME_STMT);
+    return tmp;
+}
+
+// VALUE with each reserved 11 code read as 10 (+1), the canonical word the
+// runtime's DIGITS() works on: value ^ (value & value >> 1 & lsb).
+static tree ternary_emit_digits(gimple_stmt_iterator *gsi, tree value)
+{
+    tree type = TREE_TYPE(value);
+    tree one = build_int_cst(unsigned_type_node, 1);
+    tree high = ternary_emit_op(gsi, type, RSHIFT_EXPR, value, one);
+    tree both = ternary_emit_op(gsi, type, BIT_AND_EXPR, value, high);
+    tree reserved = ternary_emit_op(gsi, type, BIT_AND_EXPR, both, ternary_trit_lsb(type));
+    return ternary_emit_op(gsi, type, BIT_XOR_EXPR, value, reserved);
+}
+
+// With -inline=select a select producing a ternary value stays a native
+// COND_EXPR. A ternary condition is true when its word differs from the packed
+// zero, which is the only encoding of 0.
+static bool ternary_select_can_inline(tree result_type, tree cond)
+{
+    if (!(opt_inline & TERNARY_INLINE_SELECT) || !ternary_inline_type_p(result_type))
+        return false;
+    return INTEGRAL_TYPE_P(TREE_TYPE(cond));
+}
+
+// The truth value of a ternary COND: nonzero exactly when the word differs
+// from the packed zero (a reserved 11 code reads as +1, so it differs too).
+// One compare replaces the tt2b decode; a word with no arithmetic mode (t128)
+// is compared in 64-bit chunks against the same pattern.
+static tree ternary_truth_flag(tree cond, gimple_stmt_iterator *gsi)
+{
+    tree type = TREE_TYPE(cond);
+    if (ternary_inline_type_p(type))
+        return ternary_emit_op(gsi, boolean_type_node, NE_EXPR, cond, ternary_trit_lsb(type));
+
+    tree chunk_type = long_long_unsigned_type_node;
+    const unsigned chunk_bits = TYPE_PRECISION(chunk_type);
+    tree flag = NULL_TREE;
+    for (unsigned pos = 0; pos < TYPE_PRECISION(type); pos += chunk_bits) {
+        tree chunk = ternary_make_temp(chunk_type, "ternary_chunk");
+        gimple *g = gimple_build_assign(chunk, build3(BIT_FIELD_REF, chunk_type, cond,
+                                                      bitsize_int(chunk_bits), bitsize_int(pos)));
+        gimple_set_location(g, gimple_location(gsi_stmt(*gsi)));
+        gsi_insert_before(gsi, g, GSI_SAME_STMT);
+        tree nonzero = ternary_emit_op(gsi, boolean_type_node, NE_EXPR, chunk,
+                                       ternary_trit_lsb(chunk_type));
+        flag = flag ? ternary_emit_op(gsi, boolean_type_node, BIT_IOR_EXPR, flag, nonzero)
+                    : nonzero;
     }
-    const int64_t max_abs = (pow3 - 1) / 2;
-    return value >= -max_abs && value <= max_abs;
+    return flag;
 }
 
-static bool ternary_pack_constant(tree value, tree type, tree *out)
+static tree ternary_select_flag(tree cond, gimple_stmt_iterator *gsi)
+{
+    tree cond_type = TREE_TYPE(cond);
+    if (COMPARISON_CLASS_P(cond) || TREE_CODE(cond_type) == BOOLEAN_TYPE)
+        return cond;
+    if (get_ternary_type_trits(cond_type, nullptr))
+        return ternary_truth_flag(cond, gsi);
+    return ternary_emit_op(gsi, boolean_type_node, NE_EXPR, cond, build_zero_cst(cond_type));
+}
+
+// neg/not and tmin/tmax are a few word operations on the packed form, the
+// same mask arithmetic as DEFINE_TERNARY_LOGIC_OPS in the runtime, reserved
+// 11 codes reading as +1. With -inline=neg or -inline=minmax the sequence
+// replaces the neg_tN/not_tN or and_tN/or_tN call. CODE is the tree code the
+// helper stands for: NEGATE_EXPR, BIT_NOT_EXPR, BIT_AND_EXPR or BIT_IOR_EXPR.
+static bool ternary_expand_inline(enum tree_code code, tree lhs, tree arg1, tree arg2,
+                                  gimple_stmt_iterator *gsi)
+{
+    unsigned cls;
+    if (code == NEGATE_EXPR || code == BIT_NOT_EXPR)
+        cls = TERNARY_INLINE_NEG;
+    else if (code == BIT_AND_EXPR || code == BIT_IOR_EXPR)
+        cls = TERNARY_INLINE_MINMAX;
+    else
+        return false;
+    if (!(opt_inline & cls) || !lhs || !arg1)
+        return false;
+
+    tree type = TREE_TYPE(lhs);
+    if (!ternary_inline_type_p(type) || !types_compatible_p(type, TREE_TYPE(arg1)))
+        return false;
+    if (cls == TERNARY_INLINE_MINMAX && (!arg2 || !types_compatible_p(type, TREE_TYPE(arg2))))
+        return false;
+
+    tree lsb = ternary_trit_lsb(type);
+    tree one = build_int_cst(unsigned_type_node, 1);
+    gimple *result;
+    if (cls == TERNARY_INLINE_NEG) {
+        // Fold 11 to 10, then subtract each digit from 2: 00 and 10 swap.
+        tree digits = ternary_emit_digits(gsi, arg1);
+        tree twos = wide_int_to_tree(type, wi::lshift(wi::to_wide(lsb), 1));
+        result = gimple_build_assign(lhs, MINUS_EXPR, twos, digits);
+    } else {
+        // A field is +1 when its high bit is set and not -1 when either bit
+        // is; tmin needs both operands to agree, tmax either.
+        const enum tree_code combine = code == BIT_AND_EXPR ? BIT_AND_EXPR : BIT_IOR_EXPR;
+        tree a_high = ternary_emit_op(gsi, type, RSHIFT_EXPR, arg1, one);
+        tree b_high = ternary_emit_op(gsi, type, RSHIFT_EXPR, arg2, one);
+        tree a_live = ternary_emit_op(gsi, type, BIT_IOR_EXPR, arg1, a_high);
+        tree b_live = ternary_emit_op(gsi, type, BIT_IOR_EXPR, arg2, b_high);
+        tree plus = ternary_emit_op(gsi, type, combine, a_high, b_high);
+        plus = ternary_emit_op(gsi, type, BIT_AND_EXPR, plus, lsb);
+        tree not_minus = ternary_emit_op(gsi, type, combine, a_live, b_live);
+        tree not_plus = ternary_emit_op(gsi, type, BIT_NOT_EXPR, plus, NULL_TREE);
+        tree zero = ternary_emit_op(gsi, type, BIT_AND_EXPR, not_minus, not_plus);
+        zero = ternary_emit_op(gsi, type, BIT_AND_EXPR, zero, lsb);
+        tree high = ternary_emit_op(gsi, type, LSHIFT_EXPR, plus, one);
+        result = gimple_build_assign(lhs, BIT_IOR_EXPR, high, zero);
+    }
+
+    gimple_set_location(result, gimple_location(gsi_stmt(*gsi)));
+    gsi_replace(gsi, result, true);
+    return true;
+}
+
+// A shift by k trits is a 2k-bit shift of the packed word: shl fills the
+// vacated low trits with the zero code 01, shr repeats the top trit, and
+// rotates are plain 2k-bit rotates. With -inline=shift a constant-count
+// shl/shr/rol/ror is expanded to those word operations in place of the
+// shl_tN family call. As in the helpers, the count is reduced modulo the width
+// and reserved 11 codes are read as 10 first, so the shr fill cannot carry.
+static bool ternary_expand_const_shift(const char *op, tree lhs, tree value, tree count,
+                                       gimple_stmt_iterator *gsi)
 {
+    if (!(opt_inline & TERNARY_INLINE_SHIFT) || !lhs || !value || !count ||
+        TREE_CODE(count) != INTEGER_CST)
+        return false;
+
+    tree type = TREE_TYPE(lhs);
     unsigned trit_count = 0;
-    if (!get_ternary_type_trits(type, &trit_count))
+    if (!ternary_inline_type_p(type) || !get_ternary_type_trits(type, &trit_count))
         return false;
-    if (trit_count > 32)
+    if (!types_compatible_p(type, TREE_TYPE(value)))
         return false;
-    if (!tree_fits_shwi_p(value))
+    const bool rotate = !strcmp(op, "rol") || !strcmp(op, "ror");
+    if (!rotate && strcmp(op, "shl") && strcmp(op, "shr"))
         return false;
 
-    int64_t logical = tree_to_shwi(value);
-    if (!ternary_value_fits_trits(logical, trit_count))
+    const unsigned prec = TYPE_PRECISION(type);
+    const unsigned bits = 2U * ((unsigned)TREE_INT_CST_LOW(count) % trit_count);
+    const location_t loc = gimple_location(gsi_stmt(*gsi));
+    const wide_int lsb = wi::udiv_trunc(wi::minus_one(prec), wi::uhwi(3, prec));
+    tree bits_tree = build_int_cst(unsigned_type_node, bits);
+    tree digits = ternary_emit_digits(gsi, value);
+
+    gimple *result;
+    if (bits == 0) {
+        result = gimple_build_assign(lhs, digits);
+    } else if (rotate) {
+        result = gimple_build_assign(lhs, !strcmp(op, "rol") ? LROTATE_EXPR : RROTATE_EXPR,
+                                     digits, bits_tree);
+    } else if (!strcmp(op, "shl")) {
+        tree shifted = ternary_emit_op(gsi, type, LSHIFT_EXPR, digits, bits_tree);
+        tree fill = wide_int_to_tree(type, wi::bit_and(lsb, wi::mask(bits, false, prec)));
+        result = gimple_build_assign(lhs, BIT_IOR_EXPR, shifted, fill);
+    } else {
+        tree top = ternary_emit_op(gsi, type, RSHIFT_EXPR, digits,
+                                   build_int_cst(unsigned_type_node, prec - 2U));
+        // Multiplying the top trit code by 01 in every vacated slot copies it there.
+        tree pattern = wide_int_to_tree(type, wi::bit_and(lsb, wi::mask(prec - bits, true, prec)));
+        tree fill = ternary_emit_op(gsi, type, MULT_EXPR, top, pattern);
+        tree shifted = ternary_emit_op(gsi, type, RSHIFT_EXPR, digits, bits_tree);
+        result = gimple_build_assign(lhs, BIT_IOR_EXPR, shifted, fill);
+    }
+
+    gimple_set_location(result, loc);
+    gsi_replace(gsi, result, true);
+    return true;
+}
+
+// Nonzero balanced-ternary digits of VALUE as SIGNS[i] * 3^EXPS[i], most
+// significant first. Returns how many there are, or 3 for more than two.
+static unsigned ternary_const_digits(int64_t value, int signs[2], unsigned exps[2])
+{
+    unsigned count = 0;
+    for (unsigned exp = 0; value != 0; ++exp) {
+        int64_t rem = value % 3;
+        value /= 3;
+        if (rem == 2) {
+            rem = -1;
+            value += 1;
+        } else if (rem == -2) {
+            rem = 1;
+            value -= 1;
+        }
+        if (rem == 0)
+            continue;
+        if (count == 2)
+            return 3;
+        signs[count] = (int)rem;
+        exps[count] = exp;
+        count++;
+    }
+    if (count == 2) {
+        std::swap(signs[0], signs[1]);
+        std::swap(exps[0], exps[1]);
+    }
+    return count;
+}
+
+// x * +-3^k is a k-trit shl and x / +-3^k is tround, which truncates like div;
+// a negative constant adds a negation. A factor with two nonzero trits (2, 4,
+// 6, 8, 10, 12, ...) becomes two shifts and an add or sub, which only beats
+// the mul call when -inline=shift expands the shifts. The statement at GSI is
+// rewritten into the shift or tround step; the steps after it are inserted
+// behind it for the main loop to lower.
+static bool ternary_reduce_const_scale(gimple_stmt_iterator *gsi, int64_t factor)
+{
+    gimple *stmt = gsi_stmt(*gsi);
+    const enum tree_code code = gimple_assign_rhs_code(stmt);
+    tree lhs = gimple_assign_lhs(stmt);
+    tree value = gimple_assign_rhs1(stmt);
+    tree type = TREE_TYPE(lhs);
+    const location_t loc = gimple_location(stmt);
+
+    int signs[2];
+    unsigned exps[2];
+    const unsigned digits = ternary_const_digits(factor, signs, exps);
+    if (digits == 0 || exps[0] == 0 || TREE_CODE(value) == INTEGER_CST ||
+        !types_compatible_p(type, TREE_TYPE(value)))
+        return false;
+    if (digits == 2 && (code != MULT_EXPR || (signs[0] < 0 && signs[1] < 0) ||
+                        !(opt_inline & TERNARY_INLINE_SHIFT) || !ternary_inline_type_p(type)))
+        return false;
+    if (digits > 2 || (code == TRUNC_DIV_EXPR && digits != 1))
+        return false;
+
+    tree decl = NULL_TREE;
+    if (code == TRUNC_DIV_EXPR && !(decl = get_tround_decl(type)))
+        return false;
+
+    tree first = (digits == 1 && signs[0] > 0) ? lhs : ternary_make_temp(type, "ternary_scaled");
+    tree count = build_int_cst(integer_type_node, exps[0]);
+    if (code == TRUNC_DIV_EXPR) {
+        gcall *call = gimple_build_call(decl, 2, value, build_int_cst(unsigned_type_node, exps[0]));
+        gimple_call_set_lhs(call, first);
+        gimple_set_location(call, loc);
+        gsi_replace(gsi, call, true);
+    } else {
+        gimple_assign_set_rhs_with_ops(gsi, LSHIFT_EXPR, value, count);
+        gimple_assign_set_lhs(gsi_stmt(*gsi), first);
+    }
+    gimple_stmt_iterator after = *gsi;
+
+    gimple *rest;
+    if (digits == 1) {
+        if (signs[0] > 0)
+            return true;
+        rest = gimple_build_assign(lhs, NEGATE_EXPR, first);
+    } else {
+        tree second = value;
+        if (exps[1] > 0) {
+            second = ternary_make_temp(type, "ternary_scaled");
+            gimple *shift = gimple_build_assign(second, LSHIFT_EXPR, value,
+                                                build_int_cst(integer_type_node, exps[1]));
+            gimple_set_location(shift, loc);
+            gsi_insert_after(&after, shift, GSI_NEW_STMT);
+        }
+        if (signs[0] < 0)
+            rest = gimple_build_assign(lhs, MINUS_EXPR, second, first);
+        else
+            rest = gimple_build_assign(lhs, signs[1] > 0 ? PLUS_EXPR : MINUS_EXPR, first, second);
+    }
+    gimple_set_location(rest, loc);
+    gsi_insert_after(&after, rest, GSI_NEW_STMT);
+    return true;
+}
+
+// Largest |value| of a trit_count-trit word: (3^n - 1) / 2.
+static widest_int ternary_trit_bound(unsigned trit_count)
+{
+    widest_int pow3 = 1;
+    for (unsigned i = 0; i < trit_count; ++i)
+        pow3 = wi::mul(pow3, 3);
+    return wi::udiv_trunc(wi::sub(pow3, 1), 2);
+}
+
+static bool ternary_value_fits_trits(const widest_int &value, unsigned trit_count)
+{
+    return wi::les_p(wi::abs(value), ternary_trit_bound(trit_count));
+}
+
+// The logical value of a literal. Ternary types are unsigned, so a negative
+// literal arrives wrapped into the type's precision and is read back signed.
+static bool ternary_logical_value(tree value, widest_int *out)
+{
+    if (TREE_CODE(value) != INTEGER_CST)
         return false;
+    if (get_ternary_type_trits(TREE_TYPE(value), nullptr))
+        *out = widest_int::from(wi::to_wide(value), SIGNED);
+    else
+        *out = wi::to_widest(value);
+    return true;
+}
 
-    uint64_t packed = 0;
-    int64_t v = logical;
+// The packed word of LOGICAL, digit by digit in widest_int so every width
+// folds exactly. LOGICAL must fit trit_count trits.
+static widest_int ternary_pack_word(const widest_int &logical, unsigned trit_count)
+{
+    widest_int packed = 0;
+    widest_int v = logical;
     for (unsigned i = 0; i < trit_count; ++i) {
-        int64_t rem = v % 3;
-        v /= 3;
+        HOST_WIDE_INT rem = wi::smod_trunc(v, 3).to_shwi();
+        v = wi::sdiv_trunc(v, 3);
         if (rem == 2) {
             rem = -1;
             v += 1;
@@ -480,31 +994,45 @@ static bool ternary_pack_constant(tree value, tree type, tree *out)
             rem = 1;
             v -= 1;
         }
-        uint64_t bits = (rem < 0) ? 0U : (rem == 0 ? 1U : 2U);
-        packed |= bits << (2U * i);
+        unsigned bits = (rem < 0) ? 0U : (rem == 0 ? 1U : 2U);
+        packed |= wi::lshift(widest_int(bits), 2U * i);
     }
-
-    *out = build_int_cst_type(type, (HOST_WIDE_INT)packed);
-    return true;
+    return packed;
 }
 
-static bool ternary_unpack_constant(tree value, tree type, int64_t *out)
+// Packs LOGICAL into a TYPE literal.
+static bool ternary_pack_value(const widest_int &logical, tree type, tree *out)
 {
     unsigned trit_count = 0;
     if (!get_ternary_type_trits(type, &trit_count))
         return false;
-    if (trit_count > 32)
+    if (!ternary_value_fits_trits(logical, trit_count))
         return false;
-    if (!tree_fits_uhwi_p(value))
+
+    const widest_int packed = ternary_pack_word(logical, trit_count);
+    *out = wide_int_to_tree(type, wide_int::from(packed, TYPE_PRECISION(type), UNSIGNED));
+    return true;
+}
+
+static bool ternary_pack_constant(tree value, tree type, tree *out)
+{
+    widest_int logical;
+    return ternary_logical_value(value, &logical) && ternary_pack_value(logical, type, out);
+}
+
+static bool ternary_unpack_constant(tree value, tree type, widest_int *out)
+{
+    unsigned trit_count = 0;
+    if (!get_ternary_type_trits(type, &trit_count) || TREE_CODE(value) != INTEGER_CST)
         return false;
 
-    uint64_t packed = (uint64_t)tree_to_uhwi(value);
-    int64_t logical = 0;
-    int64_t pow3 = 1;
+    const widest_int packed = wi::to_widest(value);
+    widest_int logical = 0;
+    widest_int pow3 = 1;
     for (unsigned i = 0; i < trit_count; ++i) {
-        unsigned bits = (unsigned)((packed >> (2U * i)) & 0x3U);
+        unsigned bits = (unsigned)wi::bit_and(wi::lrshift(packed, 2U * i), 3).to_uhwi();
         int trit = (bits == 0U) ? -1 : (bits == 1U ? 0 : 1);
-        logical += (int64_t)trit * pow3;
+        logical += pow3 * trit;
         pow3 *= 3;
     }
     *out = logical;
@@ -564,111 +1092,142 @@ static tree get_arith_decl(const char *name, tree result_type)
 {
     if (!INTEGRAL_TYPE_P(result_type) && TREE_CODE(result_type) != VECTOR_TYPE)
         return NULL_TREE;
+    if (tree decl = ternary_registered_decl(name, result_type, NULL_TREE))
+        return decl;
 
     std::string base_name = build_helper_name(name);
     unsigned trit_count = 0;
+    tree fn_type = build_function_type_list(result_type, result_type, result_type, NULL_TREE);
+    tree decl;
     if (get_ternary_type_trits(result_type, &trit_count)) {
         // Ternary arithmetic function
         char name_buf[64];
         snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
-
-        tree fn_type = build_function_type_list(result_type, result_type, result_type, NULL_TREE);
-        tree decl = build_fn_decl(name_buf, fn_type);
-        TREE_PUBLIC(decl) = 1;
-        DECL_EXTERNAL(decl) = 1;
-        DECL_ARTIFICIAL(decl) = 1;
-        return decl;
+        decl = get_helper_fn_decl(name_buf, fn_type);
     } else if (get_ternary_vector_type_trits(result_type, &trit_count)) {
         // Ternary vector arithmetic function
         char name_buf[64];
         snprintf(name_buf, sizeof(name_buf), "%s_tv%u", base_name.c_str(), trit_count);
-
-        tree fn_type = build_function_type_list(result_type, result_type, result_type, NULL_TREE);
-        tree decl = build_fn_decl(name_buf, fn_type);
-        TREE_PUBLIC(decl) = 1;
-        DECL_EXTERNAL(decl) = 1;
-        DECL_ARTIFICIAL(decl) = 1;
-        return decl;
+        decl = get_helper_fn_decl(name_buf, fn_type);
     } else {
         // Standard integer arithmetic
-        tree fn_type = build_function_type_list(result_type, result_type, result_type, NULL_TREE);
-        tree decl = build_fn_decl(base_name.c_str(), fn_type);
-        TREE_PUBLIC(decl) = 1;
-        DECL_EXTERNAL(decl) = 1;
-        DECL_ARTIFICIAL(decl) = 1;
-        return decl;
+        decl = get_helper_fn_decl(base_name.c_str(), fn_type);
     }
+    return ternary_register_decl(name, result_type, NULL_TREE, decl);
+}
+
+static tree get_muladd_decl(tree result_type)
+{
+    unsigned trit_count = 0;
+    if (!get_ternary_type_trits(result_type, &trit_count))
+        return NULL_TREE;
+    if (tree decl = ternary_registered_decl("tmuladd", result_type, NULL_TREE))
+        return decl;
+
+    char name_buf[64];
+    std::string base_name = build_helper_name("tmuladd");
+    snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
+
+    tree fn_type = build_function_type_list(result_type, result_type, result_type, result_type,
+                                            NULL_TREE);
+    return ternary_register_decl("tmuladd", result_type, NULL_TREE,
+                                 get_helper_fn_decl(name_buf, fn_type));
+}
+
+static tree get_tmux_decl(tree result_type)
+{
+    unsigned trit_count = 0;
+    if (!get_ternary_type_trits(result_type, &trit_count))
+        return NULL_TREE;
+    if (tree decl = ternary_registered_decl("tmux", result_type, NULL_TREE))
+        return decl;
+
+    char name_buf[64];
+    std::string base_name = build_helper_name("tmux");
+    snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
+
+    tree fn_type = build_function_type_list(result_type, result_type, result_type, result_type,
+                                            result_type, NULL_TREE);
+    return ternary_register_decl("tmux", result_type, NULL_TREE,
+                                 get_helper_fn_decl(name_buf, fn_type));
+}
+
+static tree get_tround_decl(tree result_type)
+{
+    unsigned trit_count = 0;
+    if (!get_ternary_type_trits(result_type, &trit_count))
+        return NULL_TREE;
+    if (tree decl = ternary_registered_decl("tround", result_type, NULL_TREE))
+        return decl;
+
+    char name_buf[64];
+    std::string base_name = build_helper_name("tround");
+    snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
+
+    tree fn_type = build_function_type_list(result_type, result_type, unsigned_type_node,
+                                            NULL_TREE);
+    return ternary_register_decl("tround", result_type, NULL_TREE,
+                                 get_helper_fn_decl(name_buf, fn_type));
 }
 
 static tree get_cmp_decl(tree result_type)
 {
     if (!INTEGRAL_TYPE_P(result_type) && TREE_CODE(result_type) != VECTOR_TYPE)
         return NULL_TREE;
+    if (tree decl = ternary_registered_decl("cmp", result_type, NULL_TREE))
+        return decl;
 
     std::string base_name = build_helper_name("cmp");
     unsigned trit_count = 0;
+    tree decl;
     if (get_ternary_type_trits(result_type, &trit_count)) {
         char name_buf[64];
         snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
 
-        tree fn_type = build_function_type_list(result_type, result_type, result_type, NULL_TREE);
-        tree decl = build_fn_decl(name_buf, fn_type);
-        TREE_PUBLIC(decl) = 1;
-        DECL_EXTERNAL(decl) = 1;
-        DECL_ARTIFICIAL(decl) = 1;
-        return decl;
+        // cmp_tN returns the order as a plain -1/0/1 int.
+        tree fn_type = build_function_type_list(integer_type_node, result_type, result_type,
+                                                NULL_TREE);
+        decl = get_helper_fn_decl(name_buf, fn_type);
     } else if (get_ternary_vector_type_trits(result_type, &trit_count)) {
         char name_buf[64];
         snprintf(name_buf, sizeof(name_buf), "%s_tv%u", base_name.c_str(), trit_count);
 
         tree fn_type = build_function_type_list(result_type, result_type, result_type, NULL_TREE);
-        tree decl = build_fn_decl(name_buf, fn_type);
-        TREE_PUBLIC(decl) = 1;
-        DECL_EXTERNAL(decl) = 1;
-        DECL_ARTIFICIAL(decl) = 1;
-        return decl;
+        decl = get_helper_fn_decl(name_buf, fn_type);
     } else {
         tree fn_type = build_function_type_list(integer_type_node, result_type, result_type, NULL_TREE);
-        tree decl = build_fn_decl(base_name.c_str(), fn_type);
-        TREE_PUBLIC(decl) = 1;
-        DECL_EXTERNAL(decl) = 1;
-        DECL_ARTIFICIAL(decl) = 1;
-        return decl;
+        decl = get_helper_fn_decl(base_name.c_str(), fn_type);
     }
+    return ternary_register_decl("cmp", result_type, NULL_TREE, decl);
 }
 
 static tree get_shift_decl(const char *name, tree result_type)
 {
     if (!INTEGRAL_TYPE_P(result_type))
         return NULL_TREE;
+    if (tree decl = ternary_registered_decl(name, result_type, integer_type_node))
+        return decl;
 
     std::string base_name = build_helper_name(name);
     unsigned trit_count = 0;
-    if (!get_ternary_type_trits(result_type, &trit_count))
-    {
-        tree fn_type = build_function_type_list(result_type, result_type, integer_type_node, NULL_TREE);
-        tree decl = build_fn_decl(base_name.c_str(), fn_type);
-        TREE_PUBLIC(decl) = 1;
-        DECL_EXTERNAL(decl) = 1;
-        DECL_ARTIFICIAL(decl) = 1;
-        return decl;
-    }
-
-    char name_buf[64];
-    snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
-
     tree fn_type = build_function_type_list(result_type, result_type, integer_type_node, NULL_TREE);
-    tree decl = build_fn_decl(name_buf, fn_type);
-    TREE_PUBLIC(decl) = 1;
-    DECL_EXTERNAL(decl) = 1;
-    DECL_ARTIFICIAL(decl) = 1;
-    return decl;
+    tree decl;
+    if (!get_ternary_type_trits(result_type, &trit_count)) {
+        decl = get_helper_fn_decl(base_name.c_str(), fn_type);
+    } else {
+        char name_buf[64];
+        snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
+        decl = get_helper_fn_decl(name_buf, fn_type);
+    }
+    return ternary_register_decl(name, result_type, integer_type_node, decl);
 }
 
 static tree get_conv_to_ternary_decl(const char *name, tree result_type, tree arg_type)
 {
     if (!INTEGRAL_TYPE_P(result_type))
         return NULL_TREE;
+    if (tree decl = ternary_registered_decl(name, result_type, arg_type))
+        return decl;
 
     std::string base_name = build_helper_name(name);
     unsigned trit_count = 0;
@@ -679,17 +1238,16 @@ static tree get_conv_to_ternary_decl(const char *name, tree result_type, tree ar
     snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
 
     tree fn_type = build_function_type_list(result_type, arg_type, NULL_TREE);
-    tree decl = build_fn_decl(name_buf, fn_type);
-    TREE_PUBLIC(decl) = 1;
-    DECL_EXTERNAL(decl) = 1;
-    DECL_ARTIFICIAL(decl) = 1;
-    return decl;
+    return ternary_register_decl(name, result_type, arg_type,
+                                 get_helper_fn_decl(name_buf, fn_type));
 }
 
 static tree get_conv_from_ternary_decl(const char *name, tree result_type, tree arg_type)
 {
     if (!INTEGRAL_TYPE_P(arg_type))
         return NULL_TREE;
+    if (tree decl = ternary_registered_decl(name, result_type, arg_type))
+        return decl;
 
     std::string base_name = build_helper_name(name);
     unsigned trit_count = 0;
@@ -700,11 +1258,8 @@ static tree get_conv_from_ternary_decl(const char *name, tree result_type, tree
     snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
 
     tree fn_type = build_function_type_list(result_type, arg_type, NULL_TREE);
-    tree decl = build_fn_decl(name_buf, fn_type);
-    TREE_PUBLIC(decl) = 1;
-    DECL_EXTERNAL(decl) = 1;
-    DECL_ARTIFICIAL(decl) = 1;
-    return decl;
+    return ternary_register_decl(name, result_type, arg_type,
+                                 get_helper_fn_decl(name_buf, fn_type));
 }
 
 static tree get_select_decl(tree result_type, tree cond_type)
@@ -715,33 +1270,26 @@ static tree get_select_decl(tree result_type, tree cond_type)
 
     unsigned trit_count = 0;
     if (get_ternary_type_trits(result_type, &trit_count)) {
-        const unsigned key = 0x40000000U | trit_count;
-        const auto it = select_decl_cache.find(key);
-        if (it != select_decl_cache.end())
-            return it->second;
+        if (tree decl = ternary_registered_decl("select", result_type, NULL_TREE))
+            return decl;
 
         char name_buf[32];
         std::string base_name = build_helper_name("select");
         snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
 
         tree fn_type = build_function_type_list(result_type, abi_cond_type, result_type, result_type, NULL_TREE);
-        tree decl = build_fn_decl(name_buf, fn_type);
-        TREE_PUBLIC(decl) = 1;
-        DECL_EXTERNAL(decl) = 1;
-        DECL_ARTIFICIAL(decl) = 1;
-
-        select_decl_cache.emplace(key, decl);
-        return decl;
+        return ternary_register_decl("select", result_type, NULL_TREE,
+                                     get_helper_fn_decl(name_buf, fn_type));
     }
     else if (INTEGRAL_TYPE_P(result_type))
     {
+        // One select_iN/uN decl serves every integer type of that width, so
+        // the registry is keyed on the canonical type of the width.
         const unsigned precision = TYPE_PRECISION(result_type);
         const bool unsigned_p = TYPE_UNSIGNED(result_type);
-        const unsigned result_key = (precision << 1) | (unsigned_p ? 1U : 0U);
-
-        const auto it = select_decl_cache.find(result_key);
-        if (it != select_decl_cache.end())
-            return it->second;
+        tree key_type = build_nonstandard_integer_type(precision, unsigned_p);
+        if (tree decl = ternary_registered_decl("select_int", key_type, NULL_TREE))
+            return decl;
 
         char name_buf[64];
         std::string base_name = build_helper_name("select");
@@ -749,68 +1297,1842 @@ static tree get_select_decl(tree result_type, tree cond_type)
         snprintf(name_buf, sizeof(name_buf), "%s_%c%u", base_name.c_str(), sign_char, precision);
 
         tree fn_type = build_function_type_list(result_type, abi_cond_type, result_type, result_type, NULL_TREE);
-        tree decl = build_fn_decl(name_buf, fn_type);
-        TREE_PUBLIC(decl) = 1;
-        DECL_EXTERNAL(decl) = 1;
-        DECL_ARTIFICIAL(decl) = 1;
+        return ternary_register_decl("select_int", key_type, NULL_TREE,
+                                     get_helper_fn_decl(name_buf, fn_type));
+    }
+    else if (SCALAR_FLOAT_TYPE_P(result_type))
+    {
+        const unsigned precision = TYPE_PRECISION(result_type);
+        if (precision != 32 && precision != 64)
+            return NULL_TREE;  // Unsupported float precision
+        tree key_type = precision == 32 ? float_type_node : double_type_node;
+        if (tree decl = ternary_registered_decl("select_float", key_type, NULL_TREE))
+            return decl;
+
+        char name_buf[64];
+        std::string base_name = build_helper_name("select");
+        snprintf(name_buf, sizeof(name_buf), "%s_f%u", base_name.c_str(), precision);
+
+        tree fn_type = build_function_type_list(result_type, abi_cond_type, result_type, result_type, NULL_TREE);
+        return ternary_register_decl("select_float", key_type, NULL_TREE,
+                                     get_helper_fn_decl(name_buf, fn_type));
+    }
+
+    return NULL_TREE;
+}
+
+static tree get_ternary_cmp_decl(const char *name, tree result_type)
+{
+    unsigned trit_count = 0;
+    if (!get_ternary_type_trits(result_type, &trit_count))
+        return NULL_TREE;
+    if (tree decl = ternary_registered_decl(name, result_type, NULL_TREE))
+        return decl;
+
+    char name_buf[32];
+    std::string base_name = build_helper_name(name);
+    snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
+
+    tree fn_type = build_function_type_list(result_type, result_type, result_type, NULL_TREE);
+    return ternary_register_decl(name, result_type, NULL_TREE,
+                                 get_helper_fn_decl(name_buf, fn_type));
+}
+
+// With -region, chains of ternary + - * / % whose intermediate values are
+// single-use temporaries are evaluated in a native signed integer type: tt2b
+// decodes each input once, the chain runs as plain arithmetic and one tb2t
+// encodes the result, replacing a helper call (and its decode/encode) per
+// operation. Helper arithmetic wraps modulo 3^n and tb2t reduces modulo 3^n,
+// so + - * may run unreduced while the native type provably holds every
+// intermediate. / and % need exact operands, i.e. values still inside the
+// trit range; anything else stays a region boundary.
+struct ternary_region_node
+{
+    gimple *stmt;
+    widest_int bound; // largest magnitude the native value can take
+    int parent;       // node consuming this value inside the region, or -1
+    int child[2];     // node producing operand i inside the region, or -1
+    tree value;       // native result once rewritten
+};
+
+static tree ternary_count_var_use(tree *tp, int *walk_subtrees, void *data)
+{
+    if (TYPE_P(*tp) || DECL_P(*tp)) {
+        if (VAR_P(*tp))
+            (*static_cast<std::map<tree, unsigned> *>(data))[*tp]++;
+        *walk_subtrees = 0;
+    }
+    return NULL_TREE;
+}
+
+// Before SSA the only def-use information is the variables themselves; count
+// how often each one is assigned and read in FUN.
+static void ternary_count_var_refs(function *fun, std::map<tree, unsigned> *uses,
+                                   std::map<tree, unsigned> *defs)
+{
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, fun)
+    {
+        for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+        {
+            gimple *stmt = gsi_stmt(gsi);
+            for (unsigned i = 0; i < gimple_num_ops(stmt); ++i) {
+                tree op = gimple_op(stmt, i);
+                if (!op)
+                    continue;
+                if (i == 0 && (is_gimple_assign(stmt) || is_gimple_call(stmt)) && VAR_P(op))
+                    (*defs)[op]++;
+                else
+                    walk_tree(&op, ternary_count_var_use, uses, NULL);
+            }
+        }
+    }
+}
+
+// A gimplifier temporary assigned once and read once: the value can move to
+// its only use.
+static bool ternary_single_use_temp_p(tree var, std::map<tree, unsigned> &uses,
+                                      std::map<tree, unsigned> &defs)
+{
+    return VAR_P(var) && DECL_ARTIFICIAL(var) && !TREE_ADDRESSABLE(var) && defs[var] == 1 &&
+           uses[var] == 1;
+}
+
+static bool ternary_region_op_p(enum tree_code code)
+{
+    return code == PLUS_EXPR || code == MINUS_EXPR || code == MULT_EXPR ||
+           code == NEGATE_EXPR || code == TRUNC_DIV_EXPR || code == TRUNC_MOD_EXPR;
+}
+
+static tree ternary_region_native_type()
+{
+    scalar_int_mode mode;
+    if (int_mode_for_size(128, 0).exists(&mode) && targetm.scalar_mode_supported_p(mode))
+        return build_nonstandard_integer_type(128, 0);
+    return long_long_integer_type_node;
+}
+
+static tree ternary_region_operand(const std::vector<ternary_region_node> &nodes,
+                                   const ternary_region_node &node, unsigned i, tree native,
+                                   gimple_stmt_iterator *gsi)
+{
+    if (node.child[i] >= 0)
+        return nodes[node.child[i]].value;
+
+    tree op = gimple_op(node.stmt, i + 1);
+    if (TREE_CODE(op) == INTEGER_CST)
+        return wide_int_to_tree(native, wide_int::from(wi::to_wide(op), TYPE_PRECISION(native),
+                                                       SIGNED));
+    if (i == 1 && node.child[0] < 0 && operand_equal_p(op, gimple_assign_rhs1(node.stmt), 0))
+        return NULL_TREE; // same input as operand 0; the caller reuses it
+
+    tree op_type = TREE_TYPE(op);
+    tree decl = get_conv_from_ternary_decl("tt2b", long_long_integer_type_node, op_type);
+    tree decoded = ternary_make_temp(long_long_integer_type_node, "ternary_in");
+    gcall *call = gimple_build_call(decl, 1, op);
+    gimple_call_set_lhs(call, decoded);
+    gimple_set_location(call, gimple_location(node.stmt));
+    gsi_insert_before(gsi, call, GSI_SAME_STMT);
+    if (types_compatible_p(native, long_long_integer_type_node))
+        return decoded;
+    return ternary_emit_op(gsi, native, NOP_EXPR, decoded, NULL_TREE);
+}
+
+static unsigned ternary_lower_binary_regions(function *fun)
+{
+    std::map<tree, unsigned> uses;
+    std::map<tree, unsigned> defs;
+    ternary_count_var_refs(fun, &uses, &defs);
+
+    basic_block bb;
+    tree native = ternary_region_native_type();
+    const widest_int limit = widest_int::from(wi::max_value(TYPE_PRECISION(native), SIGNED), SIGNED);
+    const widest_int int64_limit = widest_int::from(wi::max_value(64, SIGNED), SIGNED);
+    unsigned rewritten = 0;
+
+    FOR_EACH_BB_FN(bb, fun)
+    {
+        std::vector<ternary_region_node> nodes;
+        std::map<tree, int> def_node;
+        for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+        {
+            gimple *stmt = gsi_stmt(gsi);
+            if (!is_gimple_assign(stmt) || !ternary_region_op_p(gimple_assign_rhs_code(stmt)))
+                continue;
+            tree lhs = gimple_assign_lhs(stmt);
+            tree type = TREE_TYPE(lhs);
+            unsigned trit_count = 0;
+            if (!get_ternary_type_trits(type, &trit_count))
+                continue;
+            const widest_int trit_bound = ternary_trit_bound(trit_count);
+            if (wi::gts_p(trit_bound, int64_limit))
+                continue; // tt2b cannot return these exactly
+
+            const enum tree_code code = gimple_assign_rhs_code(stmt);
+            const unsigned nops = code == NEGATE_EXPR ? 1 : 2;
+            ternary_region_node node = {stmt, 0, -1, {-1, -1}, NULL_TREE};
+            widest_int bounds[2] = {0, 0};
+            bool usable = true;
+            for (unsigned i = 0; i < nops; ++i) {
+                tree op = gimple_op(stmt, i + 1);
+                if (TREE_CODE(op) == INTEGER_CST) {
+                    bounds[i] = wi::abs(widest_int::from(wi::to_wide(op), SIGNED));
+                    continue;
+                }
+                if (!types_compatible_p(type, TREE_TYPE(op))) {
+                    usable = false;
+                    break;
+                }
+                bounds[i] = trit_bound;
+                const auto it = def_node.find(op);
+                if (it != def_node.end() && ternary_single_use_temp_p(op, uses, defs)) {
+                    node.child[i] = it->second;
+                    bounds[i] = nodes[it->second].bound;
+                }
+            }
+            if (!usable)
+                continue;
+
+            const bool exact_ops = code == TRUNC_DIV_EXPR || code == TRUNC_MOD_EXPR;
+            for (int attempt = 0; attempt < 2; ++attempt) {
+                for (unsigned i = 0; i < nops; ++i) {
+                    if (node.child[i] >= 0 &&
+                        (attempt == 1 || (exact_ops && wi::gts_p(bounds[i], trit_bound)))) {
+                        node.child[i] = -1;
+                        bounds[i] = trit_bound;
+                    }
+                }
+                if (code == PLUS_EXPR || code == MINUS_EXPR)
+                    node.bound = wi::add(bounds[0], bounds[1]);
+                else if (code == MULT_EXPR)
+                    node.bound = wi::mul(bounds[0], bounds[1]);
+                else if (code == TRUNC_MOD_EXPR)
+                    node.bound = wi::smin(bounds[0], bounds[1]);
+                else
+                    node.bound = bounds[0];
+                if (!wi::gts_p(node.bound, limit))
+                    break;
+            }
+            if (wi::gts_p(node.bound, limit))
+                continue;
+            if (exact_ops && (wi::gts_p(bounds[0], trit_bound) || wi::gts_p(bounds[1], trit_bound)))
+                continue;
+
+            const int index = (int)nodes.size();
+            for (unsigned i = 0; i < nops; ++i)
+                if (node.child[i] >= 0)
+                    nodes[node.child[i]].parent = index;
+            nodes.push_back(node);
+            if (VAR_P(lhs))
+                def_node[lhs] = index;
+        }
+
+        // A lone operation gains nothing from the round trip through int.
+        std::vector<unsigned> region_size(nodes.size(), 0);
+        std::vector<int> region_root(nodes.size(), -1);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            int root = (int)i;
+            while (nodes[root].parent >= 0)
+                root = nodes[root].parent;
+            region_root[i] = root;
+            region_size[root]++;
+        }
+
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            ternary_region_node &node = nodes[i];
+            if (region_size[region_root[i]] < 2)
+                continue;
+
+            gimple *stmt = node.stmt;
+            gimple_stmt_iterator gsi = gsi_for_stmt(stmt);
+            const enum tree_code code = gimple_assign_rhs_code(stmt);
+            tree a = ternary_region_operand(nodes, node, 0, native, &gsi);
+            tree b = NULL_TREE;
+            if (code != NEGATE_EXPR) {
+                b = ternary_region_operand(nodes, node, 1, native, &gsi);
+                if (!b)
+                    b = a;
+            }
+
+            if (code == TRUNC_DIV_EXPR || code == TRUNC_MOD_EXPR) {
+                // The helpers return 0 for a zero divisor; divide by 1 instead
+                // and mask the quotient away.
+                tree zero = build_zero_cst(native);
+                tree is_zero = ternary_emit_op(&gsi, boolean_type_node, EQ_EXPR, b, zero);
+                tree flag = ternary_emit_op(&gsi, native, NOP_EXPR, is_zero, NULL_TREE);
+                tree divisor = ternary_emit_op(&gsi, native, PLUS_EXPR, b, flag);
+                tree quotient = ternary_emit_op(&gsi, native, code, a, divisor);
+                tree mask = ternary_emit_op(&gsi, native, MINUS_EXPR, flag,
+                                            build_one_cst(native));
+                node.value = ternary_emit_op(&gsi, native, BIT_AND_EXPR, quotient, mask);
+            } else {
+                node.value = ternary_emit_op(&gsi, native, code, a, b);
+            }
+            rewritten++;
+
+            if (node.parent >= 0) {
+                gsi_remove(&gsi, true);
+                continue;
+            }
+
+            tree lhs = gimple_assign_lhs(stmt);
+            tree type = TREE_TYPE(lhs);
+            unsigned trit_count = 0;
+            get_ternary_type_trits(type, &trit_count);
+            tree result = node.value;
+            if (wi::gts_p(node.bound, int64_limit)) {
+                const widest_int modulus = wi::add(wi::mul(ternary_trit_bound(trit_count), 2), 1);
+                result = ternary_emit_op(&gsi, native, TRUNC_MOD_EXPR, result,
+                                         wide_int_to_tree(native, modulus));
+            }
+            if (!types_compatible_p(native, long_long_integer_type_node))
+                result = ternary_emit_op(&gsi, long_long_integer_type_node, NOP_EXPR, result,
+                                         NULL_TREE);
+            tree decl = get_conv_to_ternary_decl("tb2t", type, long_long_integer_type_node);
+            gcall *call = gimple_build_call(decl, 1, result);
+            gimple_call_set_lhs(call, lhs);
+            gimple_set_location(call, gimple_location(stmt));
+            gsi_replace(&gsi, call, true);
+            if (opt_trace)
+                inform(gimple_location(call), "ternary: evaluated %u-operation region in binary",
+                       region_size[i]);
+        }
+    }
+    return rewritten;
+}
+
+// A product that only feeds an add or sub becomes one tmuladd call in place
+// of a mul and an add call. a*b - c and c - a*b negate c or a first; the
+// negation is left for the main loop, which folds it for constants and
+// honours -inline=neg. Products with a constant factor are left to the
+// constant simplifications. Runs before the main loop, on the logical
+// constants the gimplifier produced.
+static unsigned ternary_fuse_muladd(function *fun)
+{
+    std::map<tree, unsigned> uses;
+    std::map<tree, unsigned> defs;
+    ternary_count_var_refs(fun, &uses, &defs);
+
+    unsigned fused = 0;
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, fun)
+    {
+        std::map<tree, gimple *> products;
+        for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+        {
+            gimple *stmt = gsi_stmt(gsi);
+            if (gimple_code(stmt) == GIMPLE_ASM) {
+                products.clear();
+                continue;
+            }
+
+            // A pending product is only valid while its factors are unchanged.
+            tree def = gimple_get_lhs(stmt);
+            if (def && DECL_P(def)) {
+                for (auto it = products.begin(); it != products.end();) {
+                    if (gimple_assign_rhs1(it->second) == def || gimple_assign_rhs2(it->second) == def)
+                        it = products.erase(it);
+                    else
+                        ++it;
+                }
+            }
+
+            if (!is_gimple_assign(stmt))
+                continue;
+            tree lhs = gimple_assign_lhs(stmt);
+            tree type = TREE_TYPE(lhs);
+            if (!get_ternary_type_trits(type, nullptr))
+                continue;
+
+            const enum tree_code code = gimple_assign_rhs_code(stmt);
+            tree rhs1 = gimple_assign_rhs1(stmt);
+            tree rhs2 = gimple_assign_rhs2(stmt);
+            if (code == MULT_EXPR) {
+                if (TREE_CODE(rhs1) != INTEGER_CST && TREE_CODE(rhs2) != INTEGER_CST &&
+                    types_compatible_p(type, TREE_TYPE(rhs1)) &&
+                    types_compatible_p(type, TREE_TYPE(rhs2)) &&
+                    ternary_single_use_temp_p(lhs, uses, defs))
+                    products[lhs] = stmt;
+                continue;
+            }
+            if (code != PLUS_EXPR && code != MINUS_EXPR)
+                continue;
+
+            // Find the product operand; for a sub, note which side it is on.
+            bool product_first = true;
+            auto prod = products.find(rhs1);
+            if (prod == products.end()) {
+                prod = products.find(rhs2);
+                product_first = false;
+            }
+            tree decl = get_muladd_decl(type);
+            if (prod == products.end() || !decl)
+                continue;
+            tree addend = product_first ? rhs2 : rhs1;
+            const bool negate_addend = code == MINUS_EXPR && product_first;
+            const bool negate_factor = code == MINUS_EXPR && !product_first;
+
+            if (TREE_CODE(addend) == INTEGER_CST) {
+                widest_int logical;
+                tree packed = NULL_TREE;
+                if (!ternary_logical_value(addend, &logical) ||
+                    !ternary_pack_value(negate_addend ? -logical : logical, type, &packed))
+                    continue;
+                addend = packed;
+            } else if (!types_compatible_p(type, TREE_TYPE(addend))) {
+                continue;
+            } else if (negate_addend) {
+                addend = ternary_emit_op(&gsi, type, NEGATE_EXPR, addend, NULL_TREE);
+            }
+
+            gimple *mult = prod->second;
+            products.erase(prod);
+            tree factor1 = gimple_assign_rhs1(mult);
+            tree factor2 = gimple_assign_rhs2(mult);
+            if (negate_factor) {
+                factor1 = ternary_emit_op(&gsi, type, NEGATE_EXPR, factor1, NULL_TREE);
+            }
+
+            gcall *call = gimple_build_call(decl, 3, factor1, factor2, addend);
+            gimple_call_set_lhs(call, lhs);
+            gimple_set_location(call, gimple_location(stmt));
+            gsi_replace(&gsi, call, true);
+            gimple_stmt_iterator mult_gsi = gsi_for_stmt(mult);
+            gsi_remove(&mult_gsi, true);
+            fused++;
+            if (opt_trace)
+                inform(gimple_location(call), "ternary: fused multiply-%s into tmuladd",
+                       code == PLUS_EXPR ? "add" : "sub");
+        }
+    }
+    return fused;
+}
+
+// Operand constraints of an algebraic rewrite.
+enum ternary_rewrite_match {
+    TERNARY_RW_ANY,       // anything, or no operand
+    TERNARY_RW_ZERO,      // the literal 0
+    TERNARY_RW_ONE,       // the literal 1
+    TERNARY_RW_MINUS_ONE, // the literal -1
+    TERNARY_RW_SAME,      // the same value as the operand before it
+    TERNARY_RW_NEGATED    // a value computed as -x or ~x in this block; binds x
+};
+
+// What a matching statement becomes.
+enum ternary_rewrite_result {
+    TERNARY_RW_OP1,
+    TERNARY_RW_OP2,
+    TERNARY_RW_ZERO_VALUE,
+    TERNARY_RW_NEG_OP1,
+    TERNARY_RW_NEG_OP2,
+    TERNARY_RW_INNER // the x bound by TERNARY_RW_NEGATED
+};
+
+struct ternary_rewrite_rule {
+    enum tree_code code;
+    enum ternary_rewrite_match ops[3];
+    enum ternary_rewrite_result result;
+    const char *text; // shown by -trace and -stats
+};
+
+// Identities of the ternary operations, tried in order. -, ~ (tnot) and
+// x * -1 are all negation, & and | are tmin and tmax, and ^ adds tritwise
+// mod 3, so a ^ a is -a. A new identity is one more line here.
+static const ternary_rewrite_rule ternary_rewrite_rules[] = {
+    {PLUS_EXPR, {TERNARY_RW_ANY, TERNARY_RW_ZERO}, TERNARY_RW_OP1, "a + 0 -> a"},
+    {PLUS_EXPR, {TERNARY_RW_ZERO, TERNARY_RW_ANY}, TERNARY_RW_OP2, "0 + a -> a"},
+    {MINUS_EXPR, {TERNARY_RW_ANY, TERNARY_RW_ZERO}, TERNARY_RW_OP1, "a - 0 -> a"},
+    {MINUS_EXPR, {TERNARY_RW_ZERO, TERNARY_RW_ANY}, TERNARY_RW_NEG_OP2, "0 - a -> -a"},
+    {MINUS_EXPR, {TERNARY_RW_ANY, TERNARY_RW_SAME}, TERNARY_RW_ZERO_VALUE, "a - a -> 0"},
+    {MULT_EXPR, {TERNARY_RW_ANY, TERNARY_RW_ZERO}, TERNARY_RW_ZERO_VALUE, "a * 0 -> 0"},
+    {MULT_EXPR, {TERNARY_RW_ANY, TERNARY_RW_ONE}, TERNARY_RW_OP1, "a * 1 -> a"},
+    {MULT_EXPR, {TERNARY_RW_ANY, TERNARY_RW_MINUS_ONE}, TERNARY_RW_NEG_OP1, "a * -1 -> -a"},
+    {TRUNC_DIV_EXPR, {TERNARY_RW_ANY, TERNARY_RW_ONE}, TERNARY_RW_OP1, "a / 1 -> a"},
+    {TRUNC_DIV_EXPR, {TERNARY_RW_ANY, TERNARY_RW_MINUS_ONE}, TERNARY_RW_NEG_OP1, "a / -1 -> -a"},
+    {TRUNC_MOD_EXPR, {TERNARY_RW_ANY, TERNARY_RW_ONE}, TERNARY_RW_ZERO_VALUE, "a % 1 -> 0"},
+    {NEGATE_EXPR, {TERNARY_RW_NEGATED}, TERNARY_RW_INNER, "-(-a) -> a"},
+    {BIT_NOT_EXPR, {TERNARY_RW_NEGATED}, TERNARY_RW_INNER, "tnot(tnot a) -> a"},
+    {BIT_AND_EXPR, {TERNARY_RW_ANY, TERNARY_RW_SAME}, TERNARY_RW_OP1, "tmin(a, a) -> a"},
+    {BIT_IOR_EXPR, {TERNARY_RW_ANY, TERNARY_RW_SAME}, TERNARY_RW_OP1, "tmax(a, a) -> a"},
+    {BIT_XOR_EXPR, {TERNARY_RW_ANY, TERNARY_RW_ZERO}, TERNARY_RW_OP1, "xor(a, 0) -> a"},
+    {BIT_XOR_EXPR, {TERNARY_RW_ANY, TERNARY_RW_SAME}, TERNARY_RW_NEG_OP1, "xor(a, a) -> -a"},
+    {COND_EXPR, {TERNARY_RW_ANY, TERNARY_RW_ANY, TERNARY_RW_SAME}, TERNARY_RW_OP2,
+     "c ? a : a -> a"},
+};
+
+static unsigned long ternary_rewrite_hits[ARRAY_SIZE(ternary_rewrite_rules)];
+
+static bool ternary_rewrite_matches(enum ternary_rewrite_match match, tree op, tree prev,
+                                    const std::map<tree, gimple *> &negations, tree *inner)
+{
+    switch (match) {
+    case TERNARY_RW_ANY:
+        return true;
+    case TERNARY_RW_ZERO:
+        return op && TREE_CODE(op) == INTEGER_CST && integer_zerop(op);
+    case TERNARY_RW_ONE:
+        return op && TREE_CODE(op) == INTEGER_CST && integer_onep(op);
+    case TERNARY_RW_MINUS_ONE:
+        return op && TREE_CODE(op) == INTEGER_CST && integer_minus_onep(op);
+    case TERNARY_RW_SAME:
+        return op && prev && !TREE_THIS_VOLATILE(op) && operand_equal_p(op, prev, 0);
+    case TERNARY_RW_NEGATED: {
+        auto it = op ? negations.find(op) : negations.end();
+        if (it == negations.end())
+            return false;
+        *inner = gimple_assign_rhs1(it->second);
+        return true;
+    }
+    }
+    return false;
+}
+
+// A negated value can be reused later in the block while neither it nor its
+// operand is reassigned; that needs both to be locals nothing else can write.
+static bool ternary_rewrite_local_p(tree op)
+{
+    return TREE_CODE(op) == INTEGER_CST ||
+           ((VAR_P(op) || TREE_CODE(op) == PARM_DECL) && !TREE_ADDRESSABLE(op) &&
+            !is_global_var(op) && !TREE_THIS_VOLATILE(op));
+}
+
+// Applies ternary_rewrite_rules to every ternary assignment, each one until
+// no rule matches. Runs first, on the logical constants the gimplifier
+// produced; zeros it creates are packed by the main loop like any literal.
+static unsigned ternary_rewrite_identities(function *fun)
+{
+    std::map<tree, unsigned> uses;
+    std::map<tree, unsigned> defs;
+    ternary_count_var_refs(fun, &uses, &defs);
+
+    unsigned rewritten = 0;
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, fun)
+    {
+        std::map<tree, gimple *> negations;
+        for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+        {
+            gimple *stmt = gsi_stmt(gsi);
+            if (gimple_code(stmt) == GIMPLE_ASM) {
+                negations.clear();
+                continue;
+            }
+
+            tree def = gimple_get_lhs(stmt);
+            if (def && DECL_P(def)) {
+                negations.erase(def);
+                for (auto it = negations.begin(); it != negations.end();) {
+                    if (gimple_assign_rhs1(it->second) == def)
+                        it = negations.erase(it);
+                    else
+                        ++it;
+                }
+            }
+            if (!is_gimple_assign(stmt))
+                continue;
+            tree lhs = gimple_assign_lhs(stmt);
+            tree type = TREE_TYPE(lhs);
+            if (!get_ternary_type_trits(type, nullptr))
+                continue;
+
+            for (bool again = true; again;) {
+                again = false;
+                stmt = gsi_stmt(gsi);
+                const unsigned num_ops = gimple_num_ops(stmt);
+                tree ops[3] = {gimple_assign_rhs1(stmt),
+                               num_ops > 2 ? gimple_assign_rhs2(stmt) : NULL_TREE,
+                               num_ops > 3 ? gimple_assign_rhs3(stmt) : NULL_TREE};
+                for (unsigned i = 0; i < ARRAY_SIZE(ternary_rewrite_rules); ++i) {
+                    const ternary_rewrite_rule &rule = ternary_rewrite_rules[i];
+                    tree inner = NULL_TREE;
+                    if (rule.code != gimple_assign_rhs_code(stmt) ||
+                        !ternary_rewrite_matches(rule.ops[0], ops[0], NULL_TREE, negations, &inner) ||
+                        !ternary_rewrite_matches(rule.ops[1], ops[1], ops[0], negations, &inner) ||
+                        !ternary_rewrite_matches(rule.ops[2], ops[2], ops[1], negations, &inner))
+                        continue;
+
+                    switch (rule.result) {
+                    case TERNARY_RW_OP1:
+                        gimple_assign_set_rhs_from_tree(&gsi, ops[0]);
+                        break;
+                    case TERNARY_RW_OP2:
+                        gimple_assign_set_rhs_from_tree(&gsi, ops[1]);
+                        break;
+                    case TERNARY_RW_ZERO_VALUE:
+                        gimple_assign_set_rhs_from_tree(&gsi, build_int_cst(type, 0));
+                        break;
+                    case TERNARY_RW_NEG_OP1:
+                        gimple_assign_set_rhs_with_ops(&gsi, NEGATE_EXPR, ops[0]);
+                        break;
+                    case TERNARY_RW_NEG_OP2:
+                        gimple_assign_set_rhs_with_ops(&gsi, NEGATE_EXPR, ops[1]);
+                        break;
+                    case TERNARY_RW_INNER: {
+                        // The negation itself goes too once this was its only use.
+                        gimple *negation = negations[ops[0]];
+                        gimple_assign_set_rhs_from_tree(&gsi, inner);
+                        if (ternary_single_use_temp_p(ops[0], uses, defs)) {
+                            gimple_stmt_iterator neg_gsi = gsi_for_stmt(negation);
+                            gsi_remove(&neg_gsi, true);
+                            negations.erase(ops[0]);
+                        }
+                        break;
+                    }
+                    }
+                    ternary_rewrite_hits[i]++;
+                    rewritten++;
+                    again = true;
+                    if (opt_trace)
+                        inform(gimple_location(stmt), "ternary: rewrote %s", rule.text);
+                    break;
+                }
+            }
+
+            stmt = gsi_stmt(gsi);
+            const enum tree_code code = gimple_assign_rhs_code(stmt);
+            if ((code == NEGATE_EXPR || code == BIT_NOT_EXPR) && lhs != gimple_assign_rhs1(stmt) &&
+                types_compatible_p(type, TREE_TYPE(gimple_assign_rhs1(stmt))) &&
+                ternary_rewrite_local_p(lhs) && ternary_rewrite_local_p(gimple_assign_rhs1(stmt)))
+                negations[lhs] = stmt;
+        }
+    }
+    return rewritten;
+}
+
+// Compile-time model of the runtime helpers. Words decode the way the runtime
+// reads them (the reserved 11 code is +1), results come back canonical, and
+// arithmetic wraps modulo 3^n like the helpers do, so a folded call yields the
+// exact word the helper would have returned.
+struct ternary_word {
+    std::vector<int> trits; // least significant first
+    widest_int raw;         // the word as passed
+};
+
+static bool ternary_const_word(tree arg, unsigned trit_count, ternary_word *out)
+{
+    if (!arg || TREE_CODE(arg) != INTEGER_CST)
+        return false;
+    out->raw = widest_int::from(wi::to_wide(arg), UNSIGNED);
+    out->trits.resize(trit_count);
+    for (unsigned i = 0; i < trit_count; ++i) {
+        unsigned bits = (unsigned)wi::bit_and(wi::lrshift(out->raw, 2U * i), 3).to_uhwi();
+        out->trits[i] = bits == 0U ? -1 : (bits == 1U ? 0 : 1);
+    }
+    return true;
+}
+
+static widest_int ternary_trits_value(const std::vector<int> &trits)
+{
+    widest_int value = 0;
+    for (size_t i = trits.size(); i-- > 0;)
+        value = value * 3 + trits[i];
+    return value;
+}
+
+// Sign of the most significant nonzero trit, i.e. of the value.
+static int ternary_trits_sign(const std::vector<int> &trits)
+{
+    for (size_t i = trits.size(); i-- > 0;)
+        if (trits[i])
+            return trits[i];
+    return 0;
+}
+
+static widest_int ternary_trits_word(const std::vector<int> &trits)
+{
+    widest_int word = 0;
+    for (size_t i = trits.size(); i-- > 0;)
+        word = wi::lshift(word, 2) + (trits[i] < 0 ? 0 : (trits[i] == 0 ? 1 : 2));
+    return word;
+}
+
+// VALUE reduced into the balanced range of trit_count trits and packed.
+static widest_int ternary_wrap_word(const widest_int &value, unsigned trit_count)
+{
+    const widest_int bound = ternary_trit_bound(trit_count);
+    const widest_int modulus = bound * 2 + 1;
+    widest_int wrapped = wi::mod_floor(value + bound, modulus, SIGNED) - bound;
+    return ternary_pack_word(wrapped, trit_count);
+}
+
+// The runtime's bt_str parser: digits 1, 0, -1 (or +1), most significant
+// first, separated by whitespace or commas. *VALID is cleared for anything
+// else, an empty string or an int64 overflow; the helper then returns 0 bits.
+static bool ternary_parse_bt_str(tree arg, bool *valid, widest_int *out)
+{
+    STRIP_NOPS(arg);
+    if (TREE_CODE(arg) != ADDR_EXPR)
+        return false;
+    tree str = TREE_OPERAND(arg, 0);
+    if (TREE_CODE(str) == ARRAY_REF && integer_zerop(TREE_OPERAND(str, 1)))
+        str = TREE_OPERAND(str, 0);
+    if (TREE_CODE(str) != STRING_CST)
+        return false;
+
+    const char *p = TREE_STRING_POINTER(str);
+    const char *end = p + TREE_STRING_LENGTH(str);
+    widest_int acc = 0;
+    bool saw = false;
+    *valid = true;
+    while (p < end && *p) {
+        if (ISSPACE(*p) || *p == ',') {
+            ++p;
+            continue;
+        }
+        int trit;
+        if (*p == '0' || *p == '1') {
+            trit = *p == '1';
+            ++p;
+        } else if ((*p == '+' || *p == '-') && p + 1 < end && p[1] == '1') {
+            trit = *p == '+' ? 1 : -1;
+            p += 2;
+        } else {
+            *valid = false;
+            break;
+        }
+        saw = true;
+        acc = acc * 3 + trit;
+        if (!wi::fits_shwi_p(acc)) {
+            *valid = false;
+            break;
+        }
+    }
+    *valid = *valid && saw;
+    *out = acc;
+    return true;
+}
+
+// Evaluates helper OP on constant ARGS for trit_count-trit words. Returns the
+// helper's result bits, or false when the call is not one the model covers or
+// an argument is not constant.
+static bool ternary_eval_helper(const std::string &op, unsigned trit_count,
+                                const std::vector<tree> &args, bool *is_word, widest_int *out)
+{
+    const size_t nargs = args.size();
+    *is_word = true;
+    if (op == "bt_str" && nargs == 1) {
+        bool valid = false;
+        widest_int value;
+        if (!ternary_parse_bt_str(args[0], &valid, &value))
+            return false;
+        *out = valid ? ternary_wrap_word(value, trit_count) : widest_int(0);
+        return true;
+    }
+    if (op == "tb2t" && nargs == 1) {
+        if (TREE_CODE(args[0]) != INTEGER_CST)
+            return false;
+        *out = ternary_wrap_word(wi::to_widest(args[0]), trit_count);
+        return true;
+    }
+
+    if (op == "tround" && nargs == 2) {
+        ternary_word word;
+        if (!ternary_const_word(args[0], trit_count, &word) || !tree_fits_uhwi_p(args[1]))
+            return false;
+        const unsigned HOST_WIDE_INT drop = tree_to_uhwi(args[1]);
+        if (drop >= trit_count) {
+            *out = ternary_pack_word(0, trit_count);
+            return true;
+        }
+        const widest_int divisor = ternary_trit_bound((unsigned)drop) * 2 + 1;
+        *out = ternary_pack_word(wi::sdiv_trunc(ternary_trits_value(word.trits), divisor),
+                                 trit_count);
+        return true;
+    }
+
+    ternary_word w[4];
+    if (nargs > 4)
+        return false;
+    for (size_t i = 0; i < nargs; ++i)
+        if (!ternary_const_word(args[i], trit_count, &w[i]))
+            return false;
+
+    if (op == "tt2b" && nargs == 1) {
+        // The helper narrows to int64_t; only exact values are folded.
+        const widest_int value = ternary_trits_value(w[0].trits);
+        if (!wi::fits_shwi_p(value))
+            return false;
+        *is_word = false;
+        *out = value;
+        return true;
+    }
+    if (op == "cmp" && nargs == 2) {
+        const widest_int a = ternary_trits_value(w[0].trits);
+        const widest_int b = ternary_trits_value(w[1].trits);
+        *is_word = false;
+        *out = wi::lts_p(a, b) ? -1 : (wi::gts_p(a, b) ? 1 : 0);
+        return true;
+    }
+    if (op == "tmux" && nargs == 4) {
+        const int sign = ternary_trits_sign(w[0].trits);
+        *out = w[sign < 0 ? 1 : (sign == 0 ? 2 : 3)].raw;
+        return true;
+    }
+    if ((op == "txor" || op == "tequiv") && nargs == 2) {
+        const int sa = ternary_trits_sign(w[0].trits);
+        const int sb = ternary_trits_sign(w[1].trits);
+        const int trit = op == "tequiv" ? sa * sb : ((sa & 1) ^ (sb & 1)) - (sa * sb > 0);
+        *out = ternary_pack_word(trit, trit_count);
+        return true;
+    }
+    if ((op == "neg" || op == "not" || op == "tnot") && nargs == 1) {
+        for (int &t : w[0].trits)
+            t = -t;
+        *out = ternary_trits_word(w[0].trits);
+        return true;
+    }
+    if ((op == "tmin" || op == "and" || op == "tmax" || op == "or" || op == "xor") && nargs == 2) {
+        for (unsigned i = 0; i < trit_count; ++i) {
+            const int a = w[0].trits[i];
+            const int b = w[1].trits[i];
+            if (op == "xor")
+                w[0].trits[i] = ((a + b + 4) % 3) - 1;
+            else if (op == "tmin" || op == "and")
+                w[0].trits[i] = std::min(a, b);
+            else
+                w[0].trits[i] = std::max(a, b);
+        }
+        *out = ternary_trits_word(w[0].trits);
+        return true;
+    }
+
+    widest_int value;
+    if (op == "add" && nargs == 2)
+        value = ternary_trits_value(w[0].trits) + ternary_trits_value(w[1].trits);
+    else if (op == "sub" && nargs == 2)
+        value = ternary_trits_value(w[0].trits) - ternary_trits_value(w[1].trits);
+    else if (op == "mul" && nargs == 2)
+        value = ternary_trits_value(w[0].trits) * ternary_trits_value(w[1].trits);
+    else if (op == "tmuladd" && nargs == 3)
+        value = ternary_trits_value(w[0].trits) * ternary_trits_value(w[1].trits) +
+                ternary_trits_value(w[2].trits);
+    else
+        return false;
+    *out = ternary_wrap_word(value, trit_count);
+    return true;
+}
+
+// Splits a helper name into its operation and trit count: <prefix>_<op>_t<N>,
+// with either the configured -prefix or the runtime's own __ternary.
+static bool ternary_helper_op(tree fndecl, std::string *op, unsigned *trit_count)
+{
+    if (!fndecl || !DECL_NAME(fndecl))
+        return false;
+    std::string name = IDENTIFIER_POINTER(DECL_NAME(fndecl));
+    const std::string prefixes[] = {opt_prefix + "_", "__ternary_"};
+    bool matched = false;
+    for (const std::string &prefix : prefixes) {
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            name = name.substr(prefix.size());
+            matched = true;
+            break;
+        }
+    }
+    const size_t suffix = name.rfind("_t");
+    if (!matched || suffix == std::string::npos)
+        return false;
+    const std::string width = name.substr(suffix + 2);
+    if (width != "32" && width != "64" && width != "128")
+        return false;
+    *op = name.substr(0, suffix);
+    *trit_count = (unsigned)atoi(width.c_str());
+    return true;
+}
+
+// Replaces helper calls whose arguments are all constants with the word the
+// helper returns: T32_LITERAL strings, tb2t of a literal, and whatever the
+// lowering produced with constant operands. Calls that still carry a virtual
+// definition (a plain extern declaration, once in SSA) are left alone.
+static unsigned ternary_fold_helper_calls(function *fun)
+{
+    unsigned folded = 0;
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, fun)
+    {
+        for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+        {
+            gcall *call = dyn_cast<gcall *>(gsi_stmt(gsi));
+            if (!call)
+                continue;
+            tree lhs = gimple_call_lhs(call);
+            std::string op;
+            unsigned trit_count = 0;
+            if (!lhs || !INTEGRAL_TYPE_P(TREE_TYPE(lhs)) ||
+                (gimple_in_ssa_p(fun) && gimple_vdef(call)) ||
+                !ternary_helper_op(gimple_call_fndecl(call), &op, &trit_count))
+                continue;
+
+            std::vector<tree> args;
+            for (unsigned i = 0; i < gimple_call_num_args(call); ++i)
+                args.push_back(gimple_call_arg(call, i));
+            bool is_word = true;
+            widest_int result;
+            if (!ternary_eval_helper(op, trit_count, args, &is_word, &result))
+                continue;
+
+            tree type = TREE_TYPE(lhs);
+            if (is_word && TYPE_PRECISION(type) < 2 * trit_count)
+                continue;
+            if (!is_word && !wi::fits_to_tree_p(result, type))
+                continue;
+            tree value = wide_int_to_tree(type, wide_int::from(result, TYPE_PRECISION(type),
+                                                               is_word ? UNSIGNED : SIGNED));
+            gimple *assign = gimple_build_assign(lhs, value);
+            gimple_set_location(assign, gimple_location(call));
+            gsi_replace(&gsi, assign, true);
+            folded++;
+            if (opt_trace)
+                inform(gimple_location(assign), "ternary: folded constant call to %s_t%u",
+                       op.c_str(), trit_count);
+        }
+    }
+    return folded;
+}
+
+// A tb2t_tN (*TO_TERNARY) or tt2b_tN helper call with a result. Calls that
+// still carry a virtual definition are not known to be pure and are skipped.
+static bool ternary_conversion_call(gimple *stmt, bool *to_ternary, unsigned *trit_count)
+{
+    gcall *call = dyn_cast<gcall *>(stmt);
+    std::string op;
+    if (!call || !gimple_call_lhs(call) || gimple_call_num_args(call) != 1 ||
+        (gimple_in_ssa_p(cfun) && gimple_vdef(call)) ||
+        !ternary_helper_op(gimple_call_fndecl(call), &op, trit_count) ||
+        (op != "tb2t" && op != "tt2b"))
+        return false;
+    *to_ternary = op == "tb2t";
+    return true;
+}
+
+// Whether every value of integer TYPE passes through the int64 argument of
+// tb2t_tN and comes back from tt2b_tN unchanged.
+static bool ternary_int_type_in_trits(tree type, unsigned trit_count)
+{
+    if (!INTEGRAL_TYPE_P(type))
+        return false;
+    const signop sign = TYPE_SIGN(type);
+    const widest_int lo = widest_int::from(wi::min_value(TYPE_PRECISION(type), sign), sign);
+    const widest_int hi = widest_int::from(wi::max_value(TYPE_PRECISION(type), sign), sign);
+    return wi::fits_shwi_p(lo) && wi::fits_shwi_p(hi) &&
+           ternary_value_fits_trits(lo, trit_count) && ternary_value_fits_trits(hi, trit_count);
+}
+
+// Whether every tN value survives tt2b_tN, which returns an int64, into
+// integer TYPE.
+static bool ternary_trits_in_int_type(unsigned trit_count, tree type)
+{
+    if (!INTEGRAL_TYPE_P(type) || TYPE_UNSIGNED(type))
+        return false;
+    const unsigned prec = std::min(TYPE_PRECISION(type), (unsigned)HOST_BITS_PER_WIDE_INT);
+    return wi::les_p(ternary_trit_bound(trit_count),
+                     widest_int::from(wi::max_value(prec, SIGNED), SIGNED));
+}
+
+// Replaces the conversion at GSI by LHS = VALUE, converting when the types
+// differ.
+static void ternary_replace_conversion(gimple_stmt_iterator *gsi, tree lhs, tree value)
+{
+    gimple *stmt = gsi_stmt(*gsi);
+    gimple *copy = types_compatible_p(TREE_TYPE(lhs), TREE_TYPE(value))
+                       ? gimple_build_assign(lhs, value)
+                       : gimple_build_assign(lhs, NOP_EXPR, value);
+    gimple_set_location(copy, gimple_location(stmt));
+    gsi_replace(gsi, copy, true);
+}
+
+// Removes the tb2t/tt2b traffic lowering leaves behind. tb2t(tt2b(x)) is x,
+// with any reserved 11 code turned into 10, when the integer in between holds
+// every tN value; tt2b(tb2t(i)) is i when every value of i's type fits the
+// trits; and a conversion of a value that a dominating conversion already
+// converted reuses that result. Before SSA the same is done within a block,
+// for locals not reassigned in between.
+static unsigned ternary_cancel_conversions(function *fun)
+{
+    const bool ssa = gimple_in_ssa_p(fun);
+    std::map<tree, unsigned> uses;
+    std::map<tree, unsigned> defs;
+    bool free_dominators = false;
+    std::vector<basic_block> order;
+    if (ssa) {
+        // Dominator-tree preorder: a conversion is seen before every block
+        // it dominates.
+        free_dominators = !dom_info_available_p(CDI_DOMINATORS);
+        calculate_dominance_info(CDI_DOMINATORS);
+        std::vector<basic_block> stack(1, single_succ(ENTRY_BLOCK_PTR_FOR_FN(fun)));
+        while (!stack.empty()) {
+            basic_block bb = stack.back();
+            stack.pop_back();
+            order.push_back(bb);
+            for (basic_block son = first_dom_son(CDI_DOMINATORS, bb); son;
+                 son = next_dom_son(CDI_DOMINATORS, son))
+                stack.push_back(son);
+        }
+    } else {
+        ternary_count_var_refs(fun, &uses, &defs);
+        basic_block bb;
+        FOR_EACH_BB_FN(bb, fun)
+            order.push_back(bb);
+    }
+
+    unsigned removed = 0;
+    std::map<std::pair<tree, tree>, std::vector<gimple *>> seen;
+    std::map<tree, gimple *> conversions;
+    for (basic_block bb : order) {
+        if (!ssa) {
+            seen.clear();
+            conversions.clear();
+        }
+        for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+        {
+            gimple *stmt = gsi_stmt(gsi);
+            if (gimple_code(stmt) == GIMPLE_ASM) {
+                if (!ssa) {
+                    seen.clear();
+                    conversions.clear();
+                }
+                continue;
+            }
+
+            bool to_ternary = false;
+            unsigned trit_count = 0;
+            if (ternary_conversion_call(stmt, &to_ternary, &trit_count)) {
+                tree lhs = gimple_call_lhs(stmt);
+                tree arg = gimple_call_arg(stmt, 0);
+                tree fndecl = gimple_call_fndecl(stmt);
+
+                // An inverse conversion feeding this one.
+                gimple *inner = NULL;
+                if (ssa && TREE_CODE(arg) == SSA_NAME)
+                    inner = SSA_NAME_DEF_STMT(arg);
+                else if (!ssa && conversions.count(arg))
+                    inner = conversions[arg];
+                bool inner_to_ternary = false;
+                unsigned inner_trits = 0;
+                tree value = NULL_TREE;
+                bool cancelled = false;
+                if (inner && ternary_conversion_call(inner, &inner_to_ternary, &inner_trits) &&
+                    inner_to_ternary != to_ternary && inner_trits == trit_count) {
+                    tree source = gimple_call_arg(inner, 0);
+                    if (to_ternary ? (ternary_trits_in_int_type(trit_count, TREE_TYPE(arg)) &&
+                                      types_compatible_p(TREE_TYPE(source), TREE_TYPE(lhs)))
+                                   : (ternary_int_type_in_trits(TREE_TYPE(source), trit_count) &&
+                                      INTEGRAL_TYPE_P(TREE_TYPE(lhs))))
+                        value = source;
+                    cancelled = value != NULL_TREE;
+                }
+
+                // The same conversion of the same value, available here.
+                if (!value) {
+                    const auto it = seen.find(std::make_pair(fndecl, arg));
+                    if (it != seen.end())
+                        for (gimple *prev : it->second)
+                            if (!ssa || dominated_by_p(CDI_DOMINATORS, bb, gimple_bb(prev))) {
+                                value = gimple_call_lhs(prev);
+                                break;
+                            }
+                }
+
+                if (value) {
+                    // tb2t returns a canonical word, while the word tt2b read
+                    // may hold reserved 11 codes.
+                    if (cancelled && to_ternary)
+                        value = ternary_emit_digits(&gsi, value);
+                    ternary_replace_conversion(&gsi, lhs, value);
+                    removed++;
+                    if (opt_trace)
+                        inform(gimple_location(stmt), "ternary: removed redundant %s conversion",
+                               to_ternary ? "tb2t" : "tt2b");
+                    // Before SSA nothing else cleans up the inner call once
+                    // its temporary has lost its only use.
+                    if (!ssa && cancelled && ternary_single_use_temp_p(arg, uses, defs)) {
+                        gimple_stmt_iterator inner_gsi = gsi_for_stmt(inner);
+                        gsi_remove(&inner_gsi, true);
+                        conversions.erase(arg);
+                        for (auto &entry : seen)
+                            entry.second.erase(std::remove(entry.second.begin(),
+                                                           entry.second.end(), inner),
+                                               entry.second.end());
+                        removed++;
+                    }
+                    stmt = gsi_stmt(gsi);
+                }
+            }
+
+            // Before SSA a reassigned local invalidates what was recorded
+            // about it.
+            tree def = gimple_get_lhs(stmt);
+            if (!ssa && def && DECL_P(def)) {
+                conversions.erase(def);
+                for (auto it = conversions.begin(); it != conversions.end();) {
+                    if (gimple_call_arg(it->second, 0) == def)
+                        it = conversions.erase(it);
+                    else
+                        ++it;
+                }
+                for (auto it = seen.begin(); it != seen.end();) {
+                    std::vector<gimple *> &list = it->second;
+                    list.erase(std::remove_if(list.begin(), list.end(),
+                                              [def](gimple *prev) { return gimple_call_lhs(prev) == def; }),
+                               list.end());
+                    if (it->first.second == def || list.empty())
+                        it = seen.erase(it);
+                    else
+                        ++it;
+                }
+            }
+
+            if (!ternary_conversion_call(stmt, &to_ternary, &trit_count))
+                continue;
+            tree lhs = gimple_call_lhs(stmt);
+            tree arg = gimple_call_arg(stmt, 0);
+            if (ssa ? TREE_CODE(lhs) != SSA_NAME || TREE_CODE(arg) != SSA_NAME
+                    : lhs == arg || !ternary_rewrite_local_p(lhs) || !ternary_rewrite_local_p(arg) ||
+                          TREE_CODE(arg) == INTEGER_CST)
+                continue;
+            seen[std::make_pair(gimple_call_fndecl(stmt), arg)].push_back(stmt);
+            conversions[lhs] = stmt;
+        }
+    }
+
+    if (free_dominators)
+        free_dominance_info(CDI_DOMINATORS);
+    return removed;
+}
+
+// A local ternary counter that is only set, stepped by a literal and compared
+// pays an add and a cmp helper call per iteration. When every tN value fits a
+// long long the counter runs as a native integer instead. Each step reduces it
+// back into the trit range, so compares see the same wrapped value the helpers
+// would; tb2t rebuilds the ternary value where something else reads it.
+enum ternary_iv_role {
+    TERNARY_IV_SET,     // iv = literal or value of the same type
+    TERNARY_IV_STEP,    // iv = iv + literal, iv - literal
+    TERNARY_IV_COMPARE, // iv compared with a literal or value of the same type
+    TERNARY_IV_USE,     // any other read; materialized with tb2t
+    TERNARY_IV_INVALID  // any other write
+};
+
+struct ternary_iv
+{
+    bool valid = true;
+    unsigned compares = 0;
+    std::vector<basic_block> steps;                   // blocks stepping the counter
+    std::vector<basic_block> reads;                   // blocks materializing its value
+    std::vector<std::pair<basic_block, tree>> inputs; // non-literal values decoded with tt2b
+    tree native = NULL_TREE;
+};
+
+static bool ternary_iv_candidate_p(tree var, unsigned *trit_count)
+{
+    return VAR_P(var) && !TREE_ADDRESSABLE(var) && !is_global_var(var) &&
+           !TREE_THIS_VOLATILE(var) && !DECL_HARD_REGISTER(var) &&
+           get_ternary_type_trits(TREE_TYPE(var), trit_count) &&
+           ternary_trits_in_int_type(*trit_count, long_long_integer_type_node);
+}
+
+static bool ternary_iv_literal_p(tree op, unsigned trit_count)
+{
+    widest_int logical;
+    return ternary_logical_value(op, &logical) && ternary_value_fits_trits(logical, trit_count);
+}
+
+static bool ternary_iv_operand_p(tree op, tree type, unsigned trit_count)
+{
+    if (TREE_CODE(op) == INTEGER_CST)
+        return ternary_iv_literal_p(op, trit_count);
+    return is_gimple_val(op) && types_compatible_p(TREE_TYPE(op), type);
+}
+
+// The two operands of a comparison statement, or false.
+static bool ternary_iv_compare_ops(gimple *stmt, tree *op0, tree *op1)
+{
+    if (is_cond_stmt(stmt)) {
+        *op0 = gimple_cond_lhs(stmt);
+        *op1 = gimple_cond_rhs(stmt);
+        return ternary_order_code_p(gimple_cond_code(stmt));
+    }
+    if (!is_gimple_assign(stmt) || !ternary_order_code_p(gimple_assign_rhs_code(stmt)))
+        return false;
+    *op0 = gimple_assign_rhs1(stmt);
+    *op1 = gimple_assign_rhs2(stmt);
+    return true;
+}
+
+static enum ternary_iv_role ternary_iv_classify(gimple *stmt, tree var, unsigned trit_count)
+{
+    if (gimple_code(stmt) == GIMPLE_ASM)
+        return TERNARY_IV_INVALID;
+    tree type = TREE_TYPE(var);
+    if (is_gimple_assign(stmt) && gimple_assign_lhs(stmt) == var) {
+        const enum tree_code code = gimple_assign_rhs_code(stmt);
+        tree rhs1 = gimple_assign_rhs1(stmt);
+        tree rhs2 = gimple_assign_rhs2(stmt);
+        if (gimple_assign_single_p(stmt))
+            return ternary_iv_operand_p(rhs1, type, trit_count) ? TERNARY_IV_SET
+                                                                : TERNARY_IV_INVALID;
+        if ((code == PLUS_EXPR || code == MINUS_EXPR) && rhs1 == var &&
+            ternary_iv_literal_p(rhs2, trit_count))
+            return TERNARY_IV_STEP;
+        if (code == PLUS_EXPR && rhs2 == var && ternary_iv_literal_p(rhs1, trit_count))
+            return TERNARY_IV_STEP;
+        return TERNARY_IV_INVALID;
+    }
+    if (gimple_get_lhs(stmt) == var)
+        return TERNARY_IV_INVALID;
+
+    tree op0, op1;
+    if (ternary_iv_compare_ops(stmt, &op0, &op1) && (op0 == var || op1 == var) &&
+        ternary_iv_operand_p(op0, type, trit_count) && ternary_iv_operand_p(op1, type, trit_count))
+        return TERNARY_IV_COMPARE;
+    return TERNARY_IV_USE;
+}
+
+static tree ternary_collect_var_r(tree *tp, int *walk_subtrees, void *data)
+{
+    if (TYPE_P(*tp) || DECL_P(*tp)) {
+        std::vector<tree> *vars = static_cast<std::vector<tree> *>(data);
+        if (VAR_P(*tp) && std::find(vars->begin(), vars->end(), *tp) == vars->end())
+            vars->push_back(*tp);
+        *walk_subtrees = 0;
+    }
+    return NULL_TREE;
+}
+
+static tree ternary_replace_var_r(tree *tp, int *walk_subtrees, void *data)
+{
+    const std::pair<tree, tree> *replace = static_cast<std::pair<tree, tree> *>(data);
+    if (*tp == replace->first)
+        *tp = replace->second;
+    if (TYPE_P(*tp) || DECL_P(*tp))
+        *walk_subtrees = 0;
+    return NULL_TREE;
+}
+
+// A parameter FUN never assigns keeps one value throughout, so it is decoded
+// once on entry rather than at every compare.
+static bool ternary_iv_entry_value_p(tree op, const std::map<tree, bool> &written)
+{
+    return TREE_CODE(op) == PARM_DECL && !TREE_ADDRESSABLE(op) && !TREE_THIS_VOLATILE(op) &&
+           !written.count(op);
+}
+
+// Whether BB runs on every iteration of a loop that steps IV.
+static bool ternary_iv_in_step_loop(const ternary_iv &iv, basic_block bb)
+{
+    for (basic_block step : iv.steps) {
+        loop_p loop = step->loop_father;
+        if (loop_depth(loop) > 0 && flow_bb_inside_loop_p(loop, bb))
+            return true;
+    }
+    return false;
+}
+
+// OP as a native counter value: literals by their logical value, rewritten
+// counters by their native variable, parameters by their value decoded on
+// entry, anything else through tt2b.
+static tree ternary_iv_native_operand(gimple_stmt_iterator *gsi, tree op,
+                                      const std::map<tree, ternary_iv> &ivs,
+                                      const std::map<tree, tree> &entry)
+{
+    if (TREE_CODE(op) == INTEGER_CST) {
+        widest_int logical;
+        ternary_logical_value(op, &logical);
+        return wide_int_to_tree(long_long_integer_type_node, logical);
+    }
+    const auto it = ivs.find(op);
+    if (it != ivs.end())
+        return it->second.native;
+    const auto in = entry.find(op);
+    if (in != entry.end())
+        return in->second;
+    tree decl = get_conv_from_ternary_decl("tt2b", long_long_integer_type_node, TREE_TYPE(op));
+    tree decoded = ternary_make_temp(long_long_integer_type_node, "ternary_bound");
+    gcall *call = gimple_build_call(decl, 1, op);
+    gimple_call_set_lhs(call, decoded);
+    gimple_set_location(call, gimple_location(gsi_stmt(*gsi)));
+    gsi_insert_before(gsi, call, GSI_SAME_STMT);
+    return decoded;
+}
+
+// Rewrites the counters stepped inside a loop when nothing in that loop needs
+// their ternary value or decodes a bound: a tb2t or tt2b per iteration would
+// cost as much as the add it saves. Runs before the main loop, on the logical
+// constants the gimplifier produced, with the loop tree built with the CFG.
+static unsigned ternary_strength_reduce_ivs(function *fun)
+{
+    if (!loops_for_fn(fun) || loops_state_satisfies_p(fun, LOOPS_NEED_FIXUP))
+        return 0;
+
+    std::map<tree, ternary_iv> ivs;
+    std::map<tree, bool> written; // parameters FUN assigns
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, fun)
+    {
+        for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+        {
+            gimple *stmt = gsi_stmt(gsi);
+            tree lhs = gimple_get_lhs(stmt);
+            if (lhs && TREE_CODE(lhs) == PARM_DECL)
+                written[lhs] = true;
+            if (gasm *asm_stmt = dyn_cast<gasm *>(stmt)) {
+                for (unsigned i = 0; i < gimple_asm_noutputs(asm_stmt); ++i) {
+                    tree out = TREE_VALUE(gimple_asm_output_op(asm_stmt, i));
+                    if (TREE_CODE(out) == PARM_DECL)
+                        written[out] = true;
+                }
+            }
+
+            std::vector<tree> vars;
+            for (unsigned i = 0; i < gimple_num_ops(stmt); ++i)
+                if (gimple_op(stmt, i))
+                    walk_tree(gimple_op_ptr(stmt, i), ternary_collect_var_r, &vars, NULL);
+            for (tree var : vars) {
+                unsigned trit_count = 0;
+                if (!ternary_iv_candidate_p(var, &trit_count))
+                    continue;
+                ternary_iv &iv = ivs[var];
+                tree op0, op1;
+                switch (ternary_iv_classify(stmt, var, trit_count)) {
+                case TERNARY_IV_SET:
+                    if (TREE_CODE(gimple_assign_rhs1(stmt)) != INTEGER_CST)
+                        iv.inputs.push_back(std::make_pair(bb, gimple_assign_rhs1(stmt)));
+                    break;
+                case TERNARY_IV_STEP:
+                    iv.steps.push_back(bb);
+                    break;
+                case TERNARY_IV_COMPARE:
+                    iv.compares++;
+                    ternary_iv_compare_ops(stmt, &op0, &op1);
+                    if (op0 != var && TREE_CODE(op0) != INTEGER_CST)
+                        iv.inputs.push_back(std::make_pair(bb, op0));
+                    if (op1 != var && TREE_CODE(op1) != INTEGER_CST)
+                        iv.inputs.push_back(std::make_pair(bb, op1));
+                    break;
+                case TERNARY_IV_USE:
+                    iv.reads.push_back(bb);
+                    break;
+                case TERNARY_IV_INVALID:
+                    iv.valid = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::map<tree, tree> entry; // parameter -> its value decoded on entry
+    for (auto it = ivs.begin(); it != ivs.end();) {
+        ternary_iv &iv = it->second;
+        bool keep = iv.valid && iv.compares &&
+                    std::any_of(iv.steps.begin(), iv.steps.end(), [](basic_block step) {
+                        return loop_depth(step->loop_father) > 0;
+                    });
+        for (basic_block read : iv.reads)
+            keep = keep && !ternary_iv_in_step_loop(iv, read);
+        for (const auto &input : iv.inputs)
+            keep = keep && (ternary_iv_entry_value_p(input.second, written) ||
+                            !ternary_iv_in_step_loop(iv, input.first));
+        if (!keep) {
+            it = ivs.erase(it);
+            continue;
+        }
+        for (const auto &input : iv.inputs)
+            if (ternary_iv_entry_value_p(input.second, written))
+                entry[input.second] = NULL_TREE;
+        iv.native = ternary_make_temp(long_long_integer_type_node, "ternary_iv");
+        ++it;
+    }
+    if (ivs.empty())
+        return 0;
+
+    if (!entry.empty()) {
+        edge e = single_succ_edge(ENTRY_BLOCK_PTR_FOR_FN(fun));
+        basic_block first = single_pred_p(e->dest) ? e->dest : split_edge(e);
+        gimple_stmt_iterator gsi = gsi_after_labels(first);
+        for (auto &in : entry) {
+            tree decl = get_conv_from_ternary_decl("tt2b", long_long_integer_type_node,
+                                                   TREE_TYPE(in.first));
+            in.second = ternary_make_temp(long_long_integer_type_node, "ternary_bound");
+            gcall *call = gimple_build_call(decl, 1, in.first);
+            gimple_call_set_lhs(call, in.second);
+            gimple_set_location(call, DECL_SOURCE_LOCATION(in.first));
+            gsi_insert_before(&gsi, call, GSI_SAME_STMT);
+        }
+    }
+
+    unsigned rewritten = 0;
+    FOR_EACH_BB_FN(bb, fun)
+    {
+        for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+        {
+            gimple *stmt = gsi_stmt(gsi);
+            std::vector<tree> vars;
+            for (unsigned i = 0; i < gimple_num_ops(stmt); ++i)
+                if (gimple_op(stmt, i))
+                    walk_tree(gimple_op_ptr(stmt, i), ternary_collect_var_r, &vars, NULL);
+            vars.erase(std::remove_if(vars.begin(), vars.end(),
+                                      [&](tree var) { return !ivs.count(var); }),
+                       vars.end());
+            if (vars.empty())
+                continue;
+
+            tree lhs = gimple_get_lhs(stmt);
+            const auto def = lhs ? ivs.find(lhs) : ivs.end();
+            if (def != ivs.end()) {
+                tree native = def->second.native;
+                gimple *repl;
+                if (gimple_assign_single_p(stmt)) {
+                    repl = gimple_build_assign(
+                        native,
+                        ternary_iv_native_operand(&gsi, gimple_assign_rhs1(stmt), ivs, entry));
+                } else {
+                    // (iv +- step + bound + 3^n) mod 3^n - bound is the sum
+                    // wrapped into [-bound, bound]; the dividend stays positive.
+                    unsigned trit_count = 0;
+                    get_ternary_type_trits(TREE_TYPE(lhs), &trit_count);
+                    const widest_int bound = ternary_trit_bound(trit_count);
+                    const widest_int modulus = wi::add(wi::mul(bound, 2), 1);
+                    tree type = long_long_integer_type_node;
+                    tree step = gimple_assign_rhs1(stmt) == lhs ? gimple_assign_rhs2(stmt)
+                                                                : gimple_assign_rhs1(stmt);
+                    tree sum = ternary_emit_op(&gsi, type, gimple_assign_rhs_code(stmt), native,
+                                               ternary_iv_native_operand(&gsi, step, ivs, entry));
+                    tree biased = ternary_emit_op(&gsi, type, PLUS_EXPR, sum,
+                                                  wide_int_to_tree(type, bound + modulus));
+                    tree wrapped = ternary_emit_op(&gsi, type, TRUNC_MOD_EXPR, biased,
+                                                   wide_int_to_tree(type, modulus));
+                    repl = gimple_build_assign(native, MINUS_EXPR, wrapped,
+                                               wide_int_to_tree(type, bound));
+                    rewritten++;
+                    if (opt_trace)
+                        inform(gimple_location(stmt),
+                               "ternary: stepped induction variable as a native counter");
+                }
+                gimple_set_location(repl, gimple_location(stmt));
+                gsi_replace(&gsi, repl, true);
+                continue;
+            }
+
+            unsigned trit_count = 0;
+            get_ternary_type_trits(TREE_TYPE(vars[0]), &trit_count);
+            tree op0, op1;
+            if (ternary_iv_classify(stmt, vars[0], trit_count) == TERNARY_IV_COMPARE &&
+                ternary_iv_compare_ops(stmt, &op0, &op1)) {
+                op0 = ternary_iv_native_operand(&gsi, op0, ivs, entry);
+                op1 = ternary_iv_native_operand(&gsi, op1, ivs, entry);
+                if (is_cond_stmt(stmt)) {
+                    gcond *cond = as_a<gcond *>(stmt);
+                    gimple_cond_set_lhs(cond, op0);
+                    gimple_cond_set_rhs(cond, op1);
+                } else {
+                    gimple_assign_set_rhs1(stmt, op0);
+                    gimple_assign_set_rhs2(stmt, op1);
+                }
+                continue;
+            }
+
+            for (tree var : vars) {
+                tree value = ternary_make_temp(TREE_TYPE(var), "ternary_iv_value");
+                tree decl = get_conv_to_ternary_decl("tb2t", TREE_TYPE(var),
+                                                     long_long_integer_type_node);
+                gcall *call = gimple_build_call(decl, 1, ivs[var].native);
+                gimple_call_set_lhs(call, value);
+                gimple_set_location(call, gimple_location(stmt));
+                gsi_insert_before(&gsi, call, GSI_SAME_STMT);
+                std::pair<tree, tree> replace(var, value);
+                for (unsigned i = 0; i < gimple_num_ops(stmt); ++i)
+                    if (gimple_op(stmt, i))
+                        walk_tree(gimple_op_ptr(stmt, i), ternary_replace_var_r, &replace, NULL);
+            }
+        }
+    }
+    return rewritten;
+}
+
+static bool ternary_order_satisfies(enum tree_code code, int order)
+{
+    switch (code) {
+    case LT_EXPR: return order < 0;
+    case LE_EXPR: return order <= 0;
+    case GT_EXPR: return order > 0;
+    case GE_EXPR: return order >= 0;
+    case EQ_EXPR: return order == 0;
+    case NE_EXPR: return order != 0;
+    default: gcc_unreachable();
+    }
+}
+
+static bool ternary_order_code_p(enum tree_code code)
+{
+    return code == LT_EXPR || code == LE_EXPR || code == GT_EXPR || code == GE_EXPR ||
+           code == EQ_EXPR || code == NE_EXPR;
+}
+
+// The only non-debug statement of BB after its labels, or NULL.
+static gimple *ternary_sole_stmt(basic_block bb)
+{
+    gimple_stmt_iterator gsi = gsi_start_nondebug_after_labels_bb(bb);
+    if (gsi_end_p(gsi))
+        return NULL;
+    gimple *stmt = gsi_stmt(gsi);
+    gsi_next_nondebug(&gsi);
+    return gsi_end_p(gsi) ? stmt : NULL;
+}
+
+// An arm of a collapsible ?: chain: reached only from PRED, falls through to
+// a single successor and does nothing but VAR = VALUE.
+static gassign *ternary_arm_assign(basic_block bb, basic_block pred)
+{
+    if (!single_pred_p(bb) || single_pred(bb) != pred || !single_succ_p(bb))
+        return NULL;
+    gimple *stmt = ternary_sole_stmt(bb);
+    if (!stmt || !gimple_assign_single_p(stmt) || !VAR_P(gimple_assign_lhs(stmt)) ||
+        !is_gimple_val(gimple_assign_rhs1(stmt)))
+        return NULL;
+    return as_a<gassign *>(stmt);
+}
+
+// s < 0 ? x : s == 0 ? y : z, written as data. Before SSA the gimplifier has
+// turned it into three arm blocks; a nested ?: writes its own temporary and
+// copies it into the outer one in an extra join block. EDGES are the arms for
+// order -1, 0 and +1, and INNER_PRED the block holding the second compare.
+// Returns the tmux call replacing all of it, or NULL when the shape differs.
+static gcall *ternary_build_three_way_tmux(tree sel, edge edges[3], basic_block inner_pred,
+                                           std::map<tree, unsigned> &uses,
+                                           std::map<tree, unsigned> &defs, basic_block *join)
+{
+    tree type = TREE_TYPE(sel);
+    tree decl = get_tmux_decl(type);
+    if (!decl)
+        return NULL;
+
+    gassign *arms[3];
+    tree values[3];
+    tree outer_var = NULL_TREE;
+    tree inner_var = NULL_TREE;
+    basic_block inner_join = NULL;
+    *join = NULL;
+    for (int i = 0; i < 3; ++i) {
+        arms[i] = ternary_arm_assign(edges[i]->dest, edges[i]->src);
+        if (!arms[i])
+            return NULL;
+        tree var = gimple_assign_lhs(arms[i]);
+        tree value = gimple_assign_rhs1(arms[i]);
+        if (!types_compatible_p(type, TREE_TYPE(var)) || !types_compatible_p(type, TREE_TYPE(value)))
+            return NULL;
+        if (TREE_CODE(value) == INTEGER_CST && !ternary_pack_constant(value, type, &value))
+            return NULL;
+        values[i] = value;
+        basic_block next = single_succ(edges[i]->dest);
+        if (edges[i]->src == inner_pred) {
+            if ((inner_var && inner_var != var) || (inner_join && inner_join != next))
+                return NULL;
+            inner_var = var;
+            inner_join = next;
+        } else {
+            outer_var = var;
+            *join = next;
+        }
+    }
+
+    if (inner_var != outer_var || inner_join != *join) {
+        // The nested form: the inner temporary must be written by the two
+        // inner arms and read only by the copy into the outer variable.
+        gimple *copy = ternary_sole_stmt(inner_join);
+        if (!copy || !gimple_assign_single_p(copy) || gimple_assign_lhs(copy) != outer_var ||
+            gimple_assign_rhs1(copy) != inner_var || !single_succ_p(inner_join) ||
+            single_succ(inner_join) != *join || EDGE_COUNT(inner_join->preds) != 2 ||
+            !DECL_ARTIFICIAL(inner_var) || TREE_ADDRESSABLE(inner_var) ||
+            defs[inner_var] != 2 || uses[inner_var] != 1)
+            return NULL;
+    }
+
+    gcall *call = gimple_build_call(decl, 4, sel, values[0], values[1], values[2]);
+    gimple_call_set_lhs(call, outer_var);
+    return call;
+}
+
+// An int variable assigned once from cmp_tN or __builtin_ternary_cmp holds a
+// -1/0/1 order. Ternary types are unsigned to the front end, which folds
+// s < 0 to false and s > 0 to s != 0 before the plugin runs, so a sign split
+// reaches the pass only as int compares of such an order. Maps each one to
+// its call.
+static void ternary_collect_orders(function *fun, std::map<tree, unsigned> &defs,
+                                   std::map<tree, gcall *> *orders)
+{
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, fun)
+    {
+        for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+        {
+            gcall *call = dyn_cast<gcall *>(gsi_stmt(gsi));
+            if (!call || gimple_call_num_args(call) != 2)
+                continue;
+            tree lhs = gimple_call_lhs(call);
+            if (!lhs || !VAR_P(lhs) || TREE_ADDRESSABLE(lhs) || is_global_var(lhs) ||
+                !INTEGRAL_TYPE_P(TREE_TYPE(lhs)) || TYPE_UNSIGNED(TREE_TYPE(lhs)) || defs[lhs] != 1)
+                continue;
+            tree fndecl = gimple_call_fndecl(call);
+            std::string op;
+            unsigned trit_count = 0;
+            if ((ternary_helper_op(fndecl, &op, &trit_count) && op == "cmp") ||
+                ternary_builtin_kind(fndecl) == TERNARY_BUILTIN_CMP)
+                (*orders)[lhs] = call;
+        }
+    }
+}
 
-        select_decl_cache.emplace(result_key, decl);
-        return decl;
+// The ternary operand whose sign the order from CALL is: cmp(s, zero) orders
+// like s and cmp(zero, s) like -s (*NEGATED), where zero is the packed word
+// the helpers take. S must still hold the compared value at the end of BB.
+static tree ternary_order_sign_operand(gcall *call, basic_block bb, bool *negated)
+{
+    tree a = gimple_call_arg(call, 0);
+    tree b = gimple_call_arg(call, 1);
+    tree type = TREE_TYPE(a);
+    if (gimple_bb(call) != bb || !get_ternary_type_trits(type, nullptr) ||
+        !types_compatible_p(type, TREE_TYPE(b)))
+        return NULL_TREE;
+    tree zero = ternary_trit_lsb(type);
+    tree sel;
+    if (TREE_CODE(b) == INTEGER_CST && tree_int_cst_equal(b, zero)) {
+        sel = a;
+        *negated = false;
+    } else if (TREE_CODE(a) == INTEGER_CST && tree_int_cst_equal(a, zero)) {
+        sel = b;
+        *negated = true;
+    } else
+        return NULL_TREE;
+    if (TREE_CODE(sel) == INTEGER_CST)
+        return NULL_TREE;
+    if ((!VAR_P(sel) && TREE_CODE(sel) != PARM_DECL) || TREE_ADDRESSABLE(sel) ||
+        is_global_var(sel))
+        return NULL_TREE;
+    gimple_stmt_iterator gsi = gsi_for_stmt(call);
+    for (gsi_next(&gsi); !gsi_end_p(gsi); gsi_next(&gsi)) {
+        gimple *stmt = gsi_stmt(gsi);
+        if ((is_gimple_assign(stmt) || is_gimple_call(stmt)) && gimple_op(stmt, 0) == sel)
+            return NULL_TREE;
     }
-    else if (SCALAR_FLOAT_TYPE_P(result_type))
-    {
-        const unsigned precision = TYPE_PRECISION(result_type);
-        unsigned result_key = 0x80000000U | precision;  // Use high bit for float
+    return sel;
+}
 
-        const auto it = select_decl_cache.find(result_key);
-        if (it != select_decl_cache.end())
-            return it->second;
+// Collapses the two-compare chain ending BB, if there is one.
+static bool ternary_collapse_three_way_at(basic_block bb, std::map<tree, unsigned> &uses,
+                                          std::map<tree, unsigned> &defs,
+                                          std::map<tree, gcall *> &orders)
+{
+    gcond *outer = safe_dyn_cast<gcond *>(gsi_stmt(gsi_last_nondebug_bb(bb)));
+    if (!outer)
+        return false;
+    const enum tree_code outer_code = gimple_cond_code(outer);
+    tree op0 = gimple_cond_lhs(outer);
+    tree op1 = gimple_cond_rhs(outer);
+    tree type = TREE_TYPE(op0);
+    if (!ternary_order_code_p(outer_code) || TREE_CODE(op0) == INTEGER_CST ||
+        !types_compatible_p(type, TREE_TYPE(op1)))
+        return false;
 
-        char name_buf[64];
-        std::string base_name = build_helper_name("select");
-        if (precision == 32)
-            snprintf(name_buf, sizeof(name_buf), "%s_f32", base_name.c_str());
-        else if (precision == 64)
-            snprintf(name_buf, sizeof(name_buf), "%s_f64", base_name.c_str());
-        else
-            return NULL_TREE;  // Unsupported float precision
+    // Either two compares of ternary operands, or of a cmp order against 0.
+    gcall *order_call = NULL;
+    tree packed_op1 = op1;
+    if (get_ternary_type_trits(type, nullptr)) {
+        if (ternary_cmp_can_inline(op0, op1))
+            return false;
+        if (TREE_CODE(op1) == INTEGER_CST && !ternary_pack_constant(op1, type, &packed_op1))
+            return false;
+    } else {
+        const auto it = orders.find(op0);
+        if (it == orders.end() || !integer_zerop(op1))
+            return false;
+        order_call = it->second;
+    }
 
-        tree fn_type = build_function_type_list(result_type, abi_cond_type, result_type, result_type, NULL_TREE);
-        tree decl = build_fn_decl(name_buf, fn_type);
-        TREE_PUBLIC(decl) = 1;
-        DECL_EXTERNAL(decl) = 1;
-        DECL_ARTIFICIAL(decl) = 1;
+    // One arm must hold nothing but a second compare of the same operands.
+    edge outer_edges[2];
+    extract_true_false_edges_from_block(bb, &outer_edges[1], &outer_edges[0]);
+    gcond *inner = NULL;
+    bool swapped = false;
+    for (int side = 0; side < 2 && !inner; ++side) {
+        basic_block arm = outer_edges[side]->dest;
+        if (arm == bb || !single_pred_p(arm))
+            continue;
+        gimple *stmt = ternary_sole_stmt(arm);
+        if (!stmt || gimple_code(stmt) != GIMPLE_COND ||
+            !ternary_order_code_p(gimple_cond_code(stmt)))
+            continue;
+        tree lhs = gimple_cond_lhs(stmt);
+        tree rhs = gimple_cond_rhs(stmt);
+        if (operand_equal_p(lhs, op0, 0) && operand_equal_p(rhs, op1, 0))
+            inner = as_a<gcond *>(stmt);
+        else if (operand_equal_p(lhs, op1, 0) && operand_equal_p(rhs, op0, 0)) {
+            inner = as_a<gcond *>(stmt);
+            swapped = true;
+        }
+    }
+    if (!inner)
+        return false;
+    basic_block inner_bb = gimple_bb(inner);
+    edge inner_edges[2];
+    extract_true_false_edges_from_block(inner_bb, &inner_edges[1], &inner_edges[0]);
+
+    // Route each order through both compares.
+    edge edges[3];
+    for (int order = -1; order <= 1; ++order) {
+        edge e = outer_edges[ternary_order_satisfies(outer_code, order)];
+        if (e->dest == inner_bb)
+            e = inner_edges[ternary_order_satisfies(gimple_cond_code(inner),
+                                                    swapped ? -order : order)];
+        edges[order + 1] = e;
+    }
+    if (edges[0]->dest == edges[1]->dest || edges[0]->dest == edges[2]->dest ||
+        edges[1]->dest == edges[2]->dest || edges[0]->dest == inner_bb ||
+        edges[1]->dest == inner_bb || edges[2]->dest == inner_bb)
+        return false;
 
-        select_decl_cache.emplace(result_key, decl);
-        return decl;
+    location_t loc = gimple_location(outer);
+    gimple_stmt_iterator gsi = gsi_last_bb(bb);
+    basic_block join = NULL;
+    gcall *tmux = NULL;
+    bool negated = false;
+    tree sel = order_call ? ternary_order_sign_operand(order_call, bb, &negated) : NULL_TREE;
+    if (sel) {
+        edge by_sign[3] = {edges[negated ? 2 : 0], edges[1], edges[negated ? 0 : 2]};
+        tmux = ternary_build_three_way_tmux(sel, by_sign, inner_bb, uses, defs, &join);
+    }
+    if (tmux) {
+        gimple_set_location(tmux, loc);
+        gsi_insert_before(&gsi, tmux, GSI_SAME_STMT);
+        gsi_remove(&gsi, true);
+        while (EDGE_COUNT(bb->succs) > 0)
+            remove_edge(EDGE_SUCC(bb, 0));
+        make_edge(bb, join, EDGE_FALLTHRU);
+        if (opt_trace)
+            inform(loc, "ternary: collapsed three-way select into tmux");
+        return true;
     }
 
-        return NULL_TREE;
+    // A cmp order is switched on as it is; ternary operands get one cmp_tN.
+    tree order = op0;
+    if (!order_call) {
+        tree decl = get_cmp_decl(type);
+        if (!decl)
+            return false;
+        order = ternary_make_temp(integer_type_node, "ternary_cmp");
+        gcall *call = gimple_build_call(decl, 2, op0, packed_op1);
+        gimple_call_set_lhs(call, order);
+        gimple_set_location(call, loc);
+        gsi_insert_before(&gsi, call, GSI_SAME_STMT);
     }
 
-static tree get_ternary_cmp_decl(const char *name, tree result_type)
+    // Any negative order goes to the first arm, as the compares sent it.
+    tree order_type = TREE_TYPE(order);
+    basic_block dests[3] = {edges[0]->dest, edges[1]->dest, edges[2]->dest};
+    auto_vec<tree> cases;
+    cases.safe_push(build_case_label(TYPE_MIN_VALUE(order_type), build_int_cst(order_type, -1),
+                                     gimple_block_label(dests[0])));
+    cases.safe_push(build_case_label(build_int_cst(order_type, 0), NULL_TREE,
+                                     gimple_block_label(dests[1])));
+    tree default_case = build_case_label(NULL_TREE, NULL_TREE, gimple_block_label(dests[2]));
+    gswitch *sw = gimple_build_switch(order, default_case, cases);
+    gimple_set_location(sw, loc);
+    gsi_replace(&gsi, sw, false);
+    while (EDGE_COUNT(bb->succs) > 0)
+        remove_edge(EDGE_SUCC(bb, 0));
+    for (int i = 0; i < 3; ++i)
+        make_edge(bb, dests[i], 0);
+    if (opt_trace)
+        inform(loc, "ternary: collapsed three-way branch into cmp and switch");
+    return true;
+}
+
+// Two compares of the same operands that split three ways, whether written
+// as nested ?: or as an if / else if / else ladder, cost two cmp_tN calls and
+// two branches; anything on ternary operands becomes one cmp_tN call and a
+// three-way switch on the order it returns, as tbranch would route it. Data
+// selected by the sign of s, which the source can only spell as compares of
+// cmp(s, zero) against 0, becomes one tmux call on s (tmux picks by its
+// sign). Compares that stay inline (-inline=cmp, -late) are left alone. Runs
+// before the main loop, on the logical constants the gimplifier produced.
+static unsigned ternary_collapse_three_way(function *fun)
 {
-    unsigned trit_count = 0;
-    if (!get_ternary_type_trits(result_type, &trit_count))
-        return NULL_TREE;
+    unsigned collapsed = 0;
+    for (bool changed = true; changed;) {
+        changed = false;
+        // A collapse moves and drops references, so the counts are taken
+        // afresh for each one.
+        std::map<tree, unsigned> uses;
+        std::map<tree, unsigned> defs;
+        std::map<tree, gcall *> orders;
+        ternary_count_var_refs(fun, &uses, &defs);
+        ternary_collect_orders(fun, defs, &orders);
 
-    const unsigned key = 0x50000000U | trit_count;
-    const auto it = select_decl_cache.find(key);  // Reuse cache
-    if (it != select_decl_cache.end())
-        return it->second;
+        basic_block bb;
+        FOR_EACH_BB_FN(bb, fun)
+        {
+            if (ternary_collapse_three_way_at(bb, uses, defs, orders)) {
+                changed = true;
+                break;
+            }
+        }
+        if (changed) {
+            collapsed++;
+            // Removed edges may have been loop exits or latches.
+            if (loops_for_fn(fun))
+                loops_state_set(fun, LOOPS_NEED_FIXUP);
+            // The bypassed arms must not be counted or matched again.
+            free_dominance_info(CDI_DOMINATORS);
+            delete_unreachable_blocks();
+        }
+    }
+    return collapsed;
+}
 
-    char name_buf[32];
-    std::string base_name = build_helper_name(name);
-    snprintf(name_buf, sizeof(name_buf), "%s_t%u", base_name.c_str(), trit_count);
+// Per-function early exit. Most functions in a large unit never touch a
+// ternary value, so before the full walk the gate looks for any ternary-typed
+// SSA name (late instance) or, before SSA, any statement with a ternary
+// operand, a __builtin_ternary_* or helper call, or a COND_EXPR.
+static bool ternary_type_p(tree type)
+{
+    return get_ternary_type_trits(type, nullptr) || get_ternary_vector_type_trits(type, nullptr);
+}
 
-    tree fn_type = build_function_type_list(result_type, result_type, result_type, NULL_TREE);
-    tree decl = build_fn_decl(name_buf, fn_type);
-    TREE_PUBLIC(decl) = 1;
-    DECL_EXTERNAL(decl) = 1;
-    DECL_ARTIFICIAL(decl) = 1;
+static bool ternary_function_has_work(function *fun, bool late)
+{
+    if (late) {
+        unsigned i;
+        tree name;
+        FOR_EACH_SSA_NAME(i, name, fun)
+        {
+            if (ternary_type_p(TREE_TYPE(name)))
+                return true;
+        }
+        return false;
+    }
 
-    select_decl_cache.emplace(key, decl);
-    return decl;
+    basic_block bb;
+    FOR_EACH_BB_FN(bb, fun)
+    {
+        for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+        {
+            gimple *stmt = gsi_stmt(gsi);
+            if (is_gimple_assign(stmt) && gimple_assign_rhs_code(stmt) == COND_EXPR)
+                return true;
+            if (gcall *call = dyn_cast<gcall *>(stmt)) {
+                tree fndecl = gimple_call_fndecl(call);
+                std::string op;
+                unsigned trit_count;
+                if (ternary_builtin_kind(fndecl) != TERNARY_BUILTIN_NONE ||
+                    ternary_helper_op(fndecl, &op, &trit_count))
+                    return true;
+            }
+            for (unsigned i = 0; i < gimple_num_ops(stmt); ++i) {
+                tree op = gimple_op(stmt, i);
+                if (op && TREE_TYPE(op) && ternary_type_p(TREE_TYPE(op)))
+                    return true;
+            }
+        }
+    }
+    return false;
 }
 
 namespace
@@ -827,10 +3149,28 @@ const pass_data ternary_pass_data = {
     0,
 };
 
+// With -late a second instance runs after "optimized", on SSA form just
+// before expand, and lowers the selects the first instance left in place.
+const pass_data ternary_late_pass_data = {
+    GIMPLE_PASS,
+    "ternary_late",
+    OPTGROUP_NONE,
+    TV_NONE,
+    PROP_ssa | PROP_cfg,
+    0,
+    0,
+    0,
+    0,
+};
+
 class ternary_pass : public gimple_opt_pass
 {
 public:
-    ternary_pass() : gimple_opt_pass(ternary_pass_data, g) {}
+    explicit ternary_pass(bool late = false)
+        : gimple_opt_pass(late ? ternary_late_pass_data : ternary_pass_data, g),
+          late_instance(late)
+    {
+    }
 
     void set_pass_param(unsigned int n, bool value) override
     {
@@ -839,8 +3179,34 @@ public:
         (void)value;
     }
 
+    bool gate(function *fun) override
+    {
+        if (late_instance && !(opt_late && opt_lower))
+            return false;
+        return ternary_function_has_work(fun, late_instance);
+    }
+
     unsigned int execute(function *fun) override
     {
+        if (late_instance)
+            return execute_late(fun);
+
+        unsigned todo = 0;
+        if (opt_lower)
+            rewrite_count += ternary_rewrite_identities(fun);
+        if (opt_lower)
+            lowered_count += ternary_strength_reduce_ivs(fun);
+        if (opt_lower) {
+            unsigned collapsed = ternary_collapse_three_way(fun);
+            lowered_count += collapsed;
+            if (collapsed)
+                todo |= TODO_cleanup_cfg;
+        }
+        if (opt_region && opt_lower)
+            lowered_count += ternary_lower_binary_regions(fun);
+        if (opt_lower)
+            lowered_count += ternary_fuse_muladd(fun);
+
         basic_block bb;
         FOR_EACH_BB_FN(bb, fun)
         {
@@ -864,89 +3230,7 @@ public:
                         continue;
                     }
 
-                    maybe_dump_stmt(stmt);
-                    tree lhs = gimple_assign_lhs(stmt);
-                    tree cond = gimple_assign_rhs1(stmt);
-                    tree true_val = gimple_assign_rhs2(stmt);
-                    tree false_val = gimple_assign_rhs3(stmt);
-                    tree packed = NULL_TREE;
-
-                    if (TREE_CODE(cond) == INTEGER_CST && ternary_pack_constant(cond, TREE_TYPE(cond), &packed))
-                        cond = packed;
-                    if (TREE_CODE(true_val) == INTEGER_CST && ternary_pack_constant(true_val, TREE_TYPE(true_val), &packed))
-                        true_val = packed;
-                    if (TREE_CODE(false_val) == INTEGER_CST && ternary_pack_constant(false_val, TREE_TYPE(false_val), &packed))
-                        false_val = packed;
-
-                    // Simplify if cond is constant
-                    if (TREE_CODE(cond) == INTEGER_CST) {
-                        bool cond_known = false;
-                        bool cond_zero = false;
-                        if (get_ternary_type_trits(TREE_TYPE(cond), nullptr)) {
-                            int64_t logical = 0;
-                            if (ternary_unpack_constant(cond, TREE_TYPE(cond), &logical)) {
-                                cond_known = true;
-                                cond_zero = (logical == 0);
-                            }
-                        } else {
-                            cond_known = true;
-                            cond_zero = integer_zerop(cond);
-                        }
-                        if (!cond_known)
-                            goto skip_cond_simplify;
-
-                        tree selected_val = cond_zero ? false_val : true_val;
-                        gimple_assign_set_rhs_from_tree(&gsi, selected_val);
-                        lowered_count++;
-                        if (opt_trace)
-                            inform(gimple_location(stmt), "ternary: simplified constant conditional to %s", cond_zero ? "false" : "true");
-                        continue;
-                    }
-skip_cond_simplify:
-
-                    // Simplify if true_val == false_val
-                    if (operand_equal_p(true_val, false_val, 0)) {
-                        gimple_assign_set_rhs_from_tree(&gsi, true_val);
-                        lowered_count++;
-                        if (opt_trace)
-                            inform(gimple_location(stmt), "ternary: simplified conditional with equal branches");
-                        continue;
-                    }
-
-                    tree result_type = TREE_TYPE(lhs);
-                    tree cond_arg = cond;
-                    tree cond_type = TREE_TYPE(cond);
-                    unsigned cond_trits = 0;
-                    if (get_ternary_type_trits(cond_type, &cond_trits)) {
-                        tree conv_decl = get_conv_from_ternary_decl("tt2b",
-                                                                    long_long_integer_type_node,
-                                                                    cond_type);
-                        if (!conv_decl) {
-                            surviving_count++;
-                            continue;
-                        }
-
-                        tree tmp = create_tmp_var(long_long_integer_type_node, "ternary_cond");
-                        gcall *conv_call = gimple_build_call(conv_decl, 1, cond);
-                        gimple_call_set_lhs(conv_call, tmp);
-                        gsi_insert_before(&gsi, conv_call, GSI_SAME_STMT);
-                        cond_arg = tmp;
-                    } else if (!types_compatible_p(cond_type, long_long_integer_type_node)) {
-                        cond_arg = fold_convert(long_long_integer_type_node, cond);
-                    }
-
-                    tree decl = get_select_decl(result_type, cond_type);
-                    if (!decl) {
-                        surviving_count++;
-                        continue;
-                    }
-
-                    gcall *call = gimple_build_call(decl, 3, cond_arg, true_val, false_val);
-                    gimple_call_set_lhs(call, lhs);
-                    gsi_replace(&gsi, call, true);
-                    lowered_count++;
-                    if (opt_trace)
-                        inform(gimple_location(stmt), "ternary: lowered conditional operator");
+                    lower_select_stmt(&gsi, stmt);
                     continue;
                 }
 
@@ -979,30 +3263,27 @@ skip_cond_simplify:
                         tree arg1 = gimple_assign_rhs1(stmt);
                         tree arg2 = gimple_assign_rhs2(stmt);
                         tree packed = NULL_TREE;
-                        int64_t arg1_logical = 0;
-                        int64_t arg2_logical = 0;
+                        widest_int arg1_logical = 0;
+                        widest_int arg2_logical = 0;
                         bool arg1_const = false;
                         bool arg2_const = false;
 
-                        if (arg1 && TREE_CODE(arg1) == INTEGER_CST &&
-                            ternary_pack_constant(arg1, TREE_TYPE(arg1), &packed))
+                        // Literals are logical values; keep them for folding and pack the operands.
+                        if (arg1 && ternary_logical_value(arg1, &arg1_logical) &&
+                            ternary_pack_value(arg1_logical, TREE_TYPE(arg1), &packed)) {
                             arg1 = packed;
-                        if (arg2 && TREE_CODE(arg2) == INTEGER_CST &&
-                            ternary_pack_constant(arg2, TREE_TYPE(arg2), &packed))
-                            arg2 = packed;
-
-                        if (arg1 && TREE_CODE(arg1) == INTEGER_CST &&
-                            ternary_unpack_constant(arg1, lhs_type, &arg1_logical))
                             arg1_const = true;
-                        if (arg2 && TREE_CODE(arg2) == INTEGER_CST &&
-                            ternary_unpack_constant(arg2, lhs_type, &arg2_logical))
+                        }
+                        if (arg2 && ternary_logical_value(arg2, &arg2_logical) &&
+                            ternary_pack_value(arg2_logical, TREE_TYPE(arg2), &packed)) {
+                            arg2 = packed;
                             arg2_const = true;
+                        }
 
                         if (code == CONVERT_EXPR && arg1 && TREE_CODE(arg1) == INTEGER_CST) {
                             tree source_type = TREE_TYPE(arg1);
-                            if (INTEGRAL_TYPE_P(source_type) && tree_fits_shwi_p(arg1)) {
-                                tree logical_tree = build_int_cst_type(long_long_integer_type_node, tree_to_shwi(arg1));
-                                if (ternary_pack_constant(logical_tree, lhs_type, &packed)) {
+                            if (INTEGRAL_TYPE_P(source_type)) {
+                                if (ternary_pack_value(wi::to_widest(arg1), lhs_type, &packed)) {
                                     gimple_assign_set_rhs_from_tree(&gsi, packed);
                                     lowered_count++;
                                     if (opt_trace)
@@ -1012,6 +3293,18 @@ skip_cond_simplify:
                             }
                         }
 
+                        // Copies only need their literal packed; the identities
+                        // that leave them behind ran before this loop.
+                        if (gimple_assign_copy_p(stmt) && types_compatible_p(lhs_type, TREE_TYPE(arg1))) {
+                            tree literal = gimple_assign_rhs1(stmt);
+                            if (TREE_CODE(literal) == INTEGER_CST &&
+                                ternary_pack_constant(literal, lhs_type, &packed)) {
+                                gimple_assign_set_rhs1(stmt, packed);
+                                lowered_count++;
+                            }
+                            continue;
+                        }
+
                         // Check for mixed-type operations
                         if (arg1 && TREE_TYPE(arg1) != lhs_type) {
                             unsigned arg1_trits = 0;
@@ -1022,7 +3315,9 @@ skip_cond_simplify:
                                 continue;
                             }
                         }
-                        if (arg2 && TREE_TYPE(arg2) != lhs_type) {
+                        // Shift counts are plain integers, not ternary operands.
+                        if (arg2 && TREE_TYPE(arg2) != lhs_type &&
+                            code != LSHIFT_EXPR && code != RSHIFT_EXPR) {
                             unsigned arg2_trits = 0;
                             if (!get_ternary_type_trits(TREE_TYPE(arg2), &arg2_trits) || arg2_trits != trit_count) {
                                 if (opt_warn)
@@ -1034,8 +3329,7 @@ skip_cond_simplify:
 
                         // Constant folding on ternary values
                         if (code == NEGATE_EXPR && arg1_const) {
-                            tree logical_tree = build_int_cst_type(long_long_integer_type_node, -arg1_logical);
-                            if (ternary_pack_constant(logical_tree, lhs_type, &packed)) {
+                            if (ternary_pack_value(-arg1_logical, lhs_type, &packed)) {
                                 gimple_assign_set_rhs_from_tree(&gsi, packed);
                                 lowered_count++;
                                 if (opt_trace)
@@ -1043,7 +3337,7 @@ skip_cond_simplify:
                                 continue;
                             }
                         } else if (arg1_const && arg2_const) {
-                            int64_t folded_val = 0;
+                            widest_int folded_val = 0;
                             bool can_fold = true;
                             if (code == PLUS_EXPR)
                                 folded_val = arg1_logical + arg2_logical;
@@ -1052,15 +3346,15 @@ skip_cond_simplify:
                             else if (code == MULT_EXPR)
                                 folded_val = arg1_logical * arg2_logical;
                             else if (code == TRUNC_DIV_EXPR)
-                                folded_val = (arg2_logical == 0) ? 0 : (arg1_logical / arg2_logical);
+                                folded_val = (arg2_logical == 0) ? 0 : wi::sdiv_trunc(arg1_logical, arg2_logical);
                             else if (code == TRUNC_MOD_EXPR)
-                                folded_val = (arg2_logical == 0) ? 0 : (arg1_logical % arg2_logical);
+                                folded_val = (arg2_logical == 0) ? 0 : wi::smod_trunc(arg1_logical, arg2_logical);
                             else
                                 can_fold = false;
 
+                            // Results that do not fit are left to the wrapping helpers.
                             if (can_fold) {
-                                tree logical_tree = build_int_cst_type(long_long_integer_type_node, folded_val);
-                                if (ternary_pack_constant(logical_tree, lhs_type, &packed)) {
+                                if (ternary_pack_value(folded_val, lhs_type, &packed)) {
                                     gimple_assign_set_rhs_from_tree(&gsi, packed);
                                     lowered_count++;
                                     if (opt_trace)
@@ -1070,39 +3364,23 @@ skip_cond_simplify:
                             }
                         }
 
-                        // Simplifications
-                        bool simplified = false;
-                        if (code == PLUS_EXPR && arg2_const && arg2_logical == 0) {
-                            // a + 0 = a
-                            gimple_assign_set_rhs_from_tree(&gsi, arg1);
-                            simplified = true;
-                            if (opt_trace)
-                                inform(gimple_location(stmt), "ternary: simplified a + 0 to a");
-                        } else if (code == MINUS_EXPR && arg2_const && arg2_logical == 0) {
-                            // a - 0 = a
-                            gimple_assign_set_rhs_from_tree(&gsi, arg1);
-                            simplified = true;
-                            if (opt_trace)
-                                inform(gimple_location(stmt), "ternary: simplified a - 0 to a");
-                        } else if (code == MULT_EXPR && arg2_const) {
-                            if (arg2_logical == 0) {
-                                // a * 0 = 0
-                                gimple_assign_set_rhs_from_tree(&gsi, arg2);
-                                simplified = true;
-                                if (opt_trace)
-                                    inform(gimple_location(stmt), "ternary: simplified a * 0 to 0");
-                            } else if (arg2_logical == 1) {
-                                // a * 1 = a
-                                gimple_assign_set_rhs_from_tree(&gsi, arg1);
-                                simplified = true;
+                        if ((code == MULT_EXPR || code == TRUNC_DIV_EXPR) && arg2_const &&
+                            wi::fits_shwi_p(arg2_logical) &&
+                            ternary_reduce_const_scale(&gsi, arg2_logical.to_shwi())) {
+                            stmt = gsi_stmt(gsi);
+                            if (code == TRUNC_DIV_EXPR) {
+                                lowered_count++;
                                 if (opt_trace)
-                                    inform(gimple_location(stmt), "ternary: simplified a * 1 to a");
+                                    inform(gimple_location(stmt), "ternary: reduced division by power of three to tround");
+                                continue;
                             }
-                        }
-
-                        if (simplified) {
-                            lowered_count++;
-                            continue;
+                            // The product starts with a constant shift now; lower that below.
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: reduced multiply by %lld to shifts",
+                                       (long long)arg2_logical.to_shwi());
+                            code = LSHIFT_EXPR;
+                            lhs = gimple_assign_lhs(stmt);
+                            arg2 = gimple_assign_rhs2(stmt);
                         }
 
                         const char *helper_name = nullptr;
@@ -1146,6 +3424,19 @@ skip_cond_simplify:
                                 }
                             }
                         }
+                        if (ternary_expand_inline(code, lhs, arg1, arg2, &gsi)) {
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded %s inline", helper_name);
+                            continue;
+                        }
+                        if (is_shift && ternary_expand_const_shift(helper_name, lhs, gimple_assign_rhs1(stmt),
+                                                                   gimple_assign_rhs2(stmt), &gsi)) {
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded constant %s inline", helper_name);
+                            continue;
+                        }
                         if (helper_name) {
                             tree decl;
                             if (is_shift) {
@@ -1159,9 +3450,8 @@ skip_cond_simplify:
                             if (decl) {
                                 int num_args = (code == NEGATE_EXPR || code == BIT_NOT_EXPR ||
                                                 code == CONVERT_EXPR) ? 1 : 2;
-                                tree arg1 = gimple_assign_rhs1(stmt);
-                                tree arg2 = (num_args == 2) ? gimple_assign_rhs2(stmt) : NULL_TREE;
-                                gcall *call = gimple_build_call(decl, num_args, arg1, arg2);
+                                gcall *call = gimple_build_call(decl, num_args, arg1,
+                                                                num_args == 2 ? arg2 : NULL_TREE);
                                 gimple_call_set_lhs(call, lhs);
                                 gsi_replace(&gsi, call, true);
                                 lowered_count++;
@@ -1186,6 +3476,14 @@ skip_cond_simplify:
                     if (code == EQ_EXPR || code == NE_EXPR || code == LT_EXPR || code == LE_EXPR || code == GT_EXPR || code == GE_EXPR) {
                         tree arg1 = gimple_assign_rhs1(stmt);
                         tree arg2 = gimple_assign_rhs2(stmt);
+                        if (ternary_cmp_can_inline(arg1, arg2)) {
+                            gimple_assign_set_rhs1(stmt, ternary_cmp_operand(arg1));
+                            gimple_assign_set_rhs2(stmt, ternary_cmp_operand(arg2));
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: kept %s as packed unsigned compare", get_tree_code_name(code));
+                            continue;
+                        }
                         tree cmp_tmp = build_cmp_call(arg1, arg2, &gsi);
                         if (cmp_tmp) {
                             tree zero = build_int_cst(integer_type_node, 0);
@@ -1243,9 +3541,10 @@ skip_cond_simplify:
                         continue;
 
                     const char *name = IDENTIFIER_POINTER(DECL_NAME(fndecl));
+                    const ternary_builtin builtin = ternary_builtin_kind(fndecl);
                     tree lhs_type = TREE_TYPE(lhs);
 
-                    if (opt_arith && !strcmp(name, "__builtin_ternary_add"))
+                    if (opt_arith && builtin == TERNARY_BUILTIN_ADD)
                     {
                         tree decl = get_arith_decl("add", lhs_type);
                         if (decl && gimple_call_num_args(stmt) == 2)
@@ -1261,7 +3560,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_add");
                         }
                     }
-                    else if (opt_arith && !strcmp(name, "__builtin_ternary_mul"))
+                    else if (opt_arith && builtin == TERNARY_BUILTIN_MUL)
                     {
                         tree decl = get_arith_decl("mul", lhs_type);
                         if (decl && gimple_call_num_args(stmt) == 2)
@@ -1277,7 +3576,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_mul");
                         }
                     }
-                    else if (opt_arith && !strcmp(name, "__builtin_ternary_sub"))
+                    else if (opt_arith && builtin == TERNARY_BUILTIN_SUB)
                     {
                         tree decl = get_arith_decl("sub", lhs_type);
                         if (decl && gimple_call_num_args(stmt) == 2)
@@ -1293,7 +3592,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_sub");
                         }
                     }
-                    else if (opt_arith && !strcmp(name, "__builtin_ternary_div"))
+                    else if (opt_arith && builtin == TERNARY_BUILTIN_DIV)
                     {
                         tree decl = get_arith_decl("div", lhs_type);
                         if (decl && gimple_call_num_args(stmt) == 2)
@@ -1309,7 +3608,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_div");
                         }
                     }
-                    else if (opt_arith && !strcmp(name, "__builtin_ternary_mod"))
+                    else if (opt_arith && builtin == TERNARY_BUILTIN_MOD)
                     {
                         tree decl = get_arith_decl("mod", lhs_type);
                         if (decl && gimple_call_num_args(stmt) == 2)
@@ -1325,17 +3624,20 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_mod");
                         }
                     }
-                    else if (opt_arith && !strcmp(name, "__builtin_ternary_neg"))
+                    else if (opt_arith && builtin == TERNARY_BUILTIN_NEG)
                     {
-                        if (INTEGRAL_TYPE_P(lhs_type) && gimple_call_num_args(stmt) == 1)
+                        if (gimple_call_num_args(stmt) == 1 &&
+                            ternary_expand_inline(NEGATE_EXPR, lhs, gimple_call_arg(stmt, 0), NULL_TREE, &gsi))
+                        {
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded builtin __builtin_ternary_neg inline");
+                        }
+                        else if (INTEGRAL_TYPE_P(lhs_type) && gimple_call_num_args(stmt) == 1)
                         {
                             maybe_dump_stmt(stmt);
                             tree fn_type = build_function_type_list(lhs_type, lhs_type, NULL_TREE);
-                            std::string helper = build_helper_name("neg");
-                            tree decl = build_fn_decl(helper.c_str(), fn_type);
-                            TREE_PUBLIC(decl) = 1;
-                            DECL_EXTERNAL(decl) = 1;
-                            DECL_ARTIFICIAL(decl) = 1;
+                            tree decl = get_builtin_helper_decl("neg", lhs_type, fn_type);
 
                             gcall *new_call = gimple_build_call(decl, 1, gimple_call_arg(stmt, 0));
                             gimple_call_set_lhs(new_call, lhs);
@@ -1345,7 +3647,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_neg");
                         }
                     }
-                    else if (opt_cmp && !strcmp(name, "__builtin_ternary_cmp"))
+                    else if (opt_cmp && builtin == TERNARY_BUILTIN_CMP)
                     {
                         tree arg0 = gimple_call_arg(stmt, 0);
                         tree arg1 = gimple_call_arg(stmt, 1);
@@ -1362,34 +3664,50 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_cmp");
                         }
                     }
-                    else if (opt_cmp && (!strcmp(name, "__builtin_ternary_eq") ||
-                                         !strcmp(name, "__builtin_ternary_ne") ||
-                                         !strcmp(name, "__builtin_ternary_lt") ||
-                                         !strcmp(name, "__builtin_ternary_le") ||
-                                         !strcmp(name, "__builtin_ternary_gt") ||
-                                         !strcmp(name, "__builtin_ternary_ge")))
+                    else if (opt_cmp && (builtin == TERNARY_BUILTIN_EQ ||
+                                         builtin == TERNARY_BUILTIN_NE ||
+                                         builtin == TERNARY_BUILTIN_LT ||
+                                         builtin == TERNARY_BUILTIN_LE ||
+                                         builtin == TERNARY_BUILTIN_GT ||
+                                         builtin == TERNARY_BUILTIN_GE))
                     {
                         tree arg0 = gimple_call_arg(stmt, 0);
                         tree arg1 = gimple_call_arg(stmt, 1);
                         tree arg0_type = TREE_TYPE(arg0);
                         unsigned trit_count;
-                        if (get_ternary_type_trits(arg0_type, &trit_count) && gimple_call_num_args(stmt) == 2)
+                        if (gimple_call_num_args(stmt) == 2 && INTEGRAL_TYPE_P(lhs_type) &&
+                            ternary_cmp_can_inline(arg0, arg1))
+                        {
+                            enum tree_code cmp_code = EQ_EXPR;
+                            if (builtin == TERNARY_BUILTIN_NE) cmp_code = NE_EXPR;
+                            else if (builtin == TERNARY_BUILTIN_LT) cmp_code = LT_EXPR;
+                            else if (builtin == TERNARY_BUILTIN_LE) cmp_code = LE_EXPR;
+                            else if (builtin == TERNARY_BUILTIN_GT) cmp_code = GT_EXPR;
+                            else if (builtin == TERNARY_BUILTIN_GE) cmp_code = GE_EXPR;
+                            maybe_dump_stmt(stmt);
+                            tree flag = ternary_emit_op(&gsi, boolean_type_node, cmp_code,
+                                                        ternary_cmp_operand(arg0),
+                                                        ternary_cmp_operand(arg1));
+                            gimple *conv = gimple_build_assign(lhs, NOP_EXPR, flag);
+                            gimple_set_location(conv, gimple_location(stmt));
+                            gsi_replace(&gsi, conv, true);
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded builtin %s inline", name);
+                        }
+                        else if (get_ternary_type_trits(arg0_type, &trit_count) && gimple_call_num_args(stmt) == 2)
                         {
                             maybe_dump_stmt(stmt);
                             tree fn_type = build_function_type_list(integer_type_node, arg0_type, arg0_type, NULL_TREE);
                             const char *base_name = nullptr;
-                            if (!strcmp(name, "__builtin_ternary_eq")) base_name = "eq";
-                            else if (!strcmp(name, "__builtin_ternary_ne")) base_name = "ne";
-                            else if (!strcmp(name, "__builtin_ternary_lt")) base_name = "lt";
-                            else if (!strcmp(name, "__builtin_ternary_le")) base_name = "le";
-                            else if (!strcmp(name, "__builtin_ternary_gt")) base_name = "gt";
-                            else if (!strcmp(name, "__builtin_ternary_ge")) base_name = "ge";
+                            if (builtin == TERNARY_BUILTIN_EQ) base_name = "eq";
+                            else if (builtin == TERNARY_BUILTIN_NE) base_name = "ne";
+                            else if (builtin == TERNARY_BUILTIN_LT) base_name = "lt";
+                            else if (builtin == TERNARY_BUILTIN_LE) base_name = "le";
+                            else if (builtin == TERNARY_BUILTIN_GT) base_name = "gt";
+                            else if (builtin == TERNARY_BUILTIN_GE) base_name = "ge";
                             if (base_name) {
-                                std::string helper = build_helper_name(base_name);
-                                tree decl = build_fn_decl(helper.c_str(), fn_type);
-                                TREE_PUBLIC(decl) = 1;
-                                DECL_EXTERNAL(decl) = 1;
-                                DECL_ARTIFICIAL(decl) = 1;
+                                tree decl = get_builtin_helper_decl(base_name, arg0_type, fn_type);
                                 gcall *new_call = gimple_build_call(decl, 2, arg0, arg1);
                                 gimple_call_set_lhs(new_call, lhs);
                                 gsi_replace(&gsi, new_call, true);
@@ -1399,26 +3717,26 @@ skip_cond_simplify:
                             }
                         }
                     }
-                    else if (opt_cmp && (!strcmp(name, "__builtin_ternary_cmplt") ||
-                                         !strcmp(name, "__builtin_ternary_cmpeq") ||
-                                         !strcmp(name, "__builtin_ternary_cmpgt") ||
-                                         !strcmp(name, "__builtin_ternary_cmpneq") ||
-                                         !strcmp(name, "__builtin_ternary_cmplt_t64") ||
-                                         !strcmp(name, "__builtin_ternary_cmpeq_t64") ||
-                                         !strcmp(name, "__builtin_ternary_cmpgt_t64") ||
-                                         !strcmp(name, "__builtin_ternary_cmpneq_t64")))
+                    else if (opt_cmp && (builtin == TERNARY_BUILTIN_CMPLT ||
+                                         builtin == TERNARY_BUILTIN_CMPEQ ||
+                                         builtin == TERNARY_BUILTIN_CMPGT ||
+                                         builtin == TERNARY_BUILTIN_CMPNEQ ||
+                                         builtin == TERNARY_BUILTIN_CMPLT_T64 ||
+                                         builtin == TERNARY_BUILTIN_CMPEQ_T64 ||
+                                         builtin == TERNARY_BUILTIN_CMPGT_T64 ||
+                                         builtin == TERNARY_BUILTIN_CMPNEQ_T64))
                     {
                         tree arg0 = gimple_call_arg(stmt, 0);
                         tree arg1 = gimple_call_arg(stmt, 1);
                         tree arg0_type = TREE_TYPE(arg0);
                         const char *base_name = nullptr;
-                        if (!strcmp(name, "__builtin_ternary_cmplt") || !strcmp(name, "__builtin_ternary_cmplt_t64"))
+                        if (builtin == TERNARY_BUILTIN_CMPLT || builtin == TERNARY_BUILTIN_CMPLT_T64)
                             base_name = "cmplt";
-                        else if (!strcmp(name, "__builtin_ternary_cmpeq") || !strcmp(name, "__builtin_ternary_cmpeq_t64"))
+                        else if (builtin == TERNARY_BUILTIN_CMPEQ || builtin == TERNARY_BUILTIN_CMPEQ_T64)
                             base_name = "cmpeq";
-                        else if (!strcmp(name, "__builtin_ternary_cmpgt") || !strcmp(name, "__builtin_ternary_cmpgt_t64"))
+                        else if (builtin == TERNARY_BUILTIN_CMPGT || builtin == TERNARY_BUILTIN_CMPGT_T64)
                             base_name = "cmpgt";
-                        else if (!strcmp(name, "__builtin_ternary_cmpneq") || !strcmp(name, "__builtin_ternary_cmpneq_t64"))
+                        else if (builtin == TERNARY_BUILTIN_CMPNEQ || builtin == TERNARY_BUILTIN_CMPNEQ_T64)
                             base_name = "cmpneq";
                         
                         if (base_name && gimple_call_num_args(stmt) == 2)
@@ -1436,17 +3754,20 @@ skip_cond_simplify:
                             }
                         }
                     }
-                    else if (opt_logic && !strcmp(name, "__builtin_ternary_not"))
+                    else if (opt_logic && builtin == TERNARY_BUILTIN_NOT)
                     {
-                        if (INTEGRAL_TYPE_P(lhs_type) && gimple_call_num_args(stmt) == 1)
+                        if (gimple_call_num_args(stmt) == 1 &&
+                            ternary_expand_inline(BIT_NOT_EXPR, lhs, gimple_call_arg(stmt, 0), NULL_TREE, &gsi))
+                        {
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded builtin __builtin_ternary_not inline");
+                        }
+                        else if (INTEGRAL_TYPE_P(lhs_type) && gimple_call_num_args(stmt) == 1)
                         {
                             maybe_dump_stmt(stmt);
                             tree fn_type = build_function_type_list(lhs_type, lhs_type, NULL_TREE);
-                            std::string helper = build_helper_name("not");
-                            tree decl = build_fn_decl(helper.c_str(), fn_type);
-                            TREE_PUBLIC(decl) = 1;
-                            DECL_EXTERNAL(decl) = 1;
-                            DECL_ARTIFICIAL(decl) = 1;
+                            tree decl = get_builtin_helper_decl("not", lhs_type, fn_type);
 
                             gcall *new_call = gimple_build_call(decl, 1, gimple_call_arg(stmt, 0));
                             gimple_call_set_lhs(new_call, lhs);
@@ -1456,10 +3777,18 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_not");
                         }
                     }
-                    else if (opt_logic && !strcmp(name, "__builtin_ternary_and"))
+                    else if (opt_logic && builtin == TERNARY_BUILTIN_AND)
                     {
                         tree decl = get_arith_decl("and", lhs_type);
-                        if (decl && gimple_call_num_args(stmt) == 2)
+                        if (gimple_call_num_args(stmt) == 2 &&
+                            ternary_expand_inline(BIT_AND_EXPR, lhs, gimple_call_arg(stmt, 0),
+                                                  gimple_call_arg(stmt, 1), &gsi))
+                        {
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded builtin __builtin_ternary_and inline");
+                        }
+                        else if (decl && gimple_call_num_args(stmt) == 2)
                         {
                             maybe_dump_stmt(stmt);
                             gcall *new_call = gimple_build_call(decl, 2,
@@ -1472,10 +3801,18 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_and");
                         }
                     }
-                    else if (opt_logic && !strcmp(name, "__builtin_ternary_or"))
+                    else if (opt_logic && builtin == TERNARY_BUILTIN_OR)
                     {
                         tree decl = get_arith_decl("or", lhs_type);
-                        if (decl && gimple_call_num_args(stmt) == 2)
+                        if (gimple_call_num_args(stmt) == 2 &&
+                            ternary_expand_inline(BIT_IOR_EXPR, lhs, gimple_call_arg(stmt, 0),
+                                                  gimple_call_arg(stmt, 1), &gsi))
+                        {
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded builtin __builtin_ternary_or inline");
+                        }
+                        else if (decl && gimple_call_num_args(stmt) == 2)
                         {
                             maybe_dump_stmt(stmt);
                             gcall *new_call = gimple_build_call(decl, 2,
@@ -1488,7 +3825,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_or");
                         }
                     }
-                    else if (opt_logic && !strcmp(name, "__builtin_ternary_xor"))
+                    else if (opt_logic && builtin == TERNARY_BUILTIN_XOR)
                     {
                         tree decl = get_arith_decl("xor", lhs_type);
                         if (decl && gimple_call_num_args(stmt) == 2)
@@ -1504,7 +3841,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_xor");
                         }
                     }
-                    else if (opt_arith && !strcmp(name, "__builtin_ternary_select"))
+                    else if (opt_arith && builtin == TERNARY_BUILTIN_SELECT)
                     {
                         if (gimple_call_num_args(stmt) == 3)
                         {
@@ -1512,9 +3849,24 @@ skip_cond_simplify:
                             tree true_val = gimple_call_arg(stmt, 1);
                             tree false_val = gimple_call_arg(stmt, 2);
                             tree decl = get_select_decl(lhs_type, TREE_TYPE(cond));
-                            if (decl)
+                            if (ternary_select_can_inline(lhs_type, cond))
+                            {
+                                maybe_dump_stmt(stmt);
+                                tree flag = ternary_select_flag(cond, &gsi);
+                                gimple *sel = gimple_build_assign(lhs, COND_EXPR, flag, true_val, false_val);
+                                gimple_set_location(sel, gimple_location(stmt));
+                                gsi_replace(&gsi, sel, true);
+                                lowered_count++;
+                                if (opt_trace)
+                                    inform(gimple_location(stmt), "ternary: expanded builtin __builtin_ternary_select inline");
+                            }
+                            else if (decl)
                             {
                                 maybe_dump_stmt(stmt);
+                                // The helper tests a long long, not a packed word.
+                                if (get_ternary_type_trits(TREE_TYPE(cond), nullptr))
+                                    cond = ternary_emit_op(&gsi, long_long_integer_type_node, NOP_EXPR,
+                                                           ternary_truth_flag(cond, &gsi), NULL_TREE);
                                 gcall *new_call = gimple_build_call(decl, 3, cond, true_val, false_val);
                                 gimple_call_set_lhs(new_call, lhs);
                                 gsi_replace(&gsi, new_call, true);
@@ -1524,10 +3876,18 @@ skip_cond_simplify:
                             }
                         }
                     }
-                    else if (opt_shift && !strcmp(name, "__builtin_ternary_shl"))
+                    else if (opt_shift && builtin == TERNARY_BUILTIN_SHL)
                     {
                         tree decl = get_shift_decl("shl", lhs_type);
-                        if (decl && gimple_call_num_args(stmt) == 2)
+                        if (gimple_call_num_args(stmt) == 2 &&
+                            ternary_expand_const_shift("shl", lhs, gimple_call_arg(stmt, 0),
+                                                       gimple_call_arg(stmt, 1), &gsi))
+                        {
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded builtin __builtin_ternary_shl inline");
+                        }
+                        else if (decl && gimple_call_num_args(stmt) == 2)
                         {
                             maybe_dump_stmt(stmt);
                             gcall *new_call = gimple_build_call(decl, 2,
@@ -1540,10 +3900,18 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_shl");
                         }
                     }
-                    else if (opt_shift && !strcmp(name, "__builtin_ternary_shr"))
+                    else if (opt_shift && builtin == TERNARY_BUILTIN_SHR)
                     {
                         tree decl = get_shift_decl("shr", lhs_type);
-                        if (decl && gimple_call_num_args(stmt) == 2)
+                        if (gimple_call_num_args(stmt) == 2 &&
+                            ternary_expand_const_shift("shr", lhs, gimple_call_arg(stmt, 0),
+                                                       gimple_call_arg(stmt, 1), &gsi))
+                        {
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded builtin __builtin_ternary_shr inline");
+                        }
+                        else if (decl && gimple_call_num_args(stmt) == 2)
                         {
                             maybe_dump_stmt(stmt);
                             gcall *new_call = gimple_build_call(decl, 2,
@@ -1556,10 +3924,18 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_shr");
                         }
                     }
-                    else if (opt_shift && !strcmp(name, "__builtin_ternary_rol"))
+                    else if (opt_shift && builtin == TERNARY_BUILTIN_ROL)
                     {
                         tree decl = get_shift_decl("rol", lhs_type);
-                        if (decl && gimple_call_num_args(stmt) == 2)
+                        if (gimple_call_num_args(stmt) == 2 &&
+                            ternary_expand_const_shift("rol", lhs, gimple_call_arg(stmt, 0),
+                                                       gimple_call_arg(stmt, 1), &gsi))
+                        {
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded builtin __builtin_ternary_rol inline");
+                        }
+                        else if (decl && gimple_call_num_args(stmt) == 2)
                         {
                             maybe_dump_stmt(stmt);
                             gcall *new_call = gimple_build_call(decl, 2,
@@ -1572,10 +3948,18 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_rol");
                         }
                     }
-                    else if (opt_shift && !strcmp(name, "__builtin_ternary_ror"))
+                    else if (opt_shift && builtin == TERNARY_BUILTIN_ROR)
                     {
                         tree decl = get_shift_decl("ror", lhs_type);
-                        if (decl && gimple_call_num_args(stmt) == 2)
+                        if (gimple_call_num_args(stmt) == 2 &&
+                            ternary_expand_const_shift("ror", lhs, gimple_call_arg(stmt, 0),
+                                                       gimple_call_arg(stmt, 1), &gsi))
+                        {
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: expanded builtin __builtin_ternary_ror inline");
+                        }
+                        else if (decl && gimple_call_num_args(stmt) == 2)
                         {
                             maybe_dump_stmt(stmt);
                             gcall *new_call = gimple_build_call(decl, 2,
@@ -1588,7 +3972,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_ror");
                         }
                     }
-                    else if (opt_conv && !strcmp(name, "__builtin_ternary_tb2t"))
+                    else if (opt_conv && builtin == TERNARY_BUILTIN_TB2T)
                     {
                         tree arg0 = gimple_call_arg(stmt, 0);
                         tree decl = get_conv_to_ternary_decl("tb2t", lhs_type, TREE_TYPE(arg0));
@@ -1603,7 +3987,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_tb2t");
                         }
                     }
-                    else if (opt_conv && !strcmp(name, "__builtin_ternary_tt2b"))
+                    else if (opt_conv && builtin == TERNARY_BUILTIN_TT2B)
                     {
                         tree arg0 = gimple_call_arg(stmt, 0);
                         tree decl = get_conv_from_ternary_decl("tt2b", lhs_type, TREE_TYPE(arg0));
@@ -1618,7 +4002,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_tt2b");
                         }
                     }
-                    else if (opt_conv && !strcmp(name, "__builtin_ternary_t2f"))
+                    else if (opt_conv && builtin == TERNARY_BUILTIN_T2F)
                     {
                         tree arg0 = gimple_call_arg(stmt, 0);
                         if (SCALAR_FLOAT_TYPE_P(lhs_type) && gimple_call_num_args(stmt) == 1)
@@ -1642,7 +4026,7 @@ skip_cond_simplify:
                             }
                         }
                     }
-                    else if (opt_conv && !strcmp(name, "__builtin_ternary_f2t"))
+                    else if (opt_conv && builtin == TERNARY_BUILTIN_F2T)
                     {
                         tree arg0 = gimple_call_arg(stmt, 0);
                         if (SCALAR_FLOAT_TYPE_P(TREE_TYPE(arg0)) && gimple_call_num_args(stmt) == 1)
@@ -1673,8 +4057,8 @@ skip_cond_simplify:
                 {
                     tree lhs = gimple_call_lhs(stmt);
                     tree lhs_type = lhs ? TREE_TYPE(lhs) : NULL_TREE;
-                    const char *name = IDENTIFIER_POINTER(DECL_NAME(gimple_call_fndecl(stmt)));
-                    if (!strcmp(name, "__builtin_ternary_load_t32"))
+                    const ternary_builtin builtin = ternary_builtin_kind(gimple_call_fndecl(stmt));
+                    if (builtin == TERNARY_BUILTIN_LOAD_T32)
                     {
                         if (gimple_call_num_args(stmt) == 1)
                         {
@@ -1687,7 +4071,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_load_t32");
                         }
                     }
-                    else if (!strcmp(name, "__builtin_ternary_store_t32"))
+                    else if (builtin == TERNARY_BUILTIN_STORE_T32)
                     {
                         if (gimple_call_num_args(stmt) == 2)
                         {
@@ -1703,7 +4087,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_store_t32");
                         }
                     }
-                    else if (!strcmp(name, "__builtin_ternary_load_t64"))
+                    else if (builtin == TERNARY_BUILTIN_LOAD_T64)
                     {
                         if (gimple_call_num_args(stmt) == 1)
                         {
@@ -1716,7 +4100,7 @@ skip_cond_simplify:
                                 inform(gimple_location(stmt), "ternary: lowered builtin __builtin_ternary_load_t64");
                         }
                     }
-                    else if (!strcmp(name, "__builtin_ternary_store_t64"))
+                    else if (builtin == TERNARY_BUILTIN_STORE_T64)
                     {
                         if (gimple_call_num_args(stmt) == 2)
                         {
@@ -1755,6 +4139,14 @@ skip_cond_simplify:
                     enum tree_code code = gimple_cond_code(stmt);
                     if (code == EQ_EXPR || code == NE_EXPR || code == LT_EXPR || code == LE_EXPR ||
                         code == GT_EXPR || code == GE_EXPR) {
+                        if (ternary_cmp_can_inline(lhs, rhs)) {
+                            gimple_cond_set_lhs(cond_stmt, ternary_cmp_operand(lhs));
+                            gimple_cond_set_rhs(cond_stmt, ternary_cmp_operand(rhs));
+                            lowered_count++;
+                            if (opt_trace)
+                                inform(gimple_location(stmt), "ternary: kept branch %s as packed unsigned compare", get_tree_code_name(code));
+                            continue;
+                        }
                         tree cmp_tmp = build_cmp_call(lhs, rhs, &gsi);
                         if (cmp_tmp) {
                             tree zero = build_int_cst(integer_type_node, 0);
@@ -1791,11 +4183,188 @@ skip_cond_simplify:
             }
         }
 
+        if (opt_lower) {
+            lowered_count += ternary_fold_helper_calls(fun);
+            conversion_count += ternary_cancel_conversions(fun);
+        }
+        return todo;
+    }
+
+private:
+    const bool late_instance;
+
+    // Lowers a COND_EXPR assignment to the select helper. Before SSA the
+    // operands still hold logical constants and are packed here; by the time
+    // the late instance runs they have been packed already.
+    void lower_select_stmt(gimple_stmt_iterator *gsi, gimple *stmt)
+    {
+        maybe_dump_stmt(stmt);
+        tree lhs = gimple_assign_lhs(stmt);
+        tree cond = gimple_assign_rhs1(stmt);
+        tree true_val = gimple_assign_rhs2(stmt);
+        tree false_val = gimple_assign_rhs3(stmt);
+        tree packed = NULL_TREE;
+
+        if (!late_instance) {
+            if (TREE_CODE(cond) == INTEGER_CST && ternary_pack_constant(cond, TREE_TYPE(cond), &packed))
+                cond = packed;
+            if (TREE_CODE(true_val) == INTEGER_CST && ternary_pack_constant(true_val, TREE_TYPE(true_val), &packed))
+                true_val = packed;
+            if (TREE_CODE(false_val) == INTEGER_CST && ternary_pack_constant(false_val, TREE_TYPE(false_val), &packed))
+                false_val = packed;
+        }
+
+        // Simplify if cond is constant
+        if (TREE_CODE(cond) == INTEGER_CST) {
+            bool cond_known = false;
+            bool cond_zero = false;
+            if (get_ternary_type_trits(TREE_TYPE(cond), nullptr)) {
+                widest_int logical;
+                if (ternary_unpack_constant(cond, TREE_TYPE(cond), &logical)) {
+                    cond_known = true;
+                    cond_zero = (logical == 0);
+                }
+            } else {
+                cond_known = true;
+                cond_zero = integer_zerop(cond);
+            }
+            if (cond_known) {
+                tree selected_val = cond_zero ? false_val : true_val;
+                gimple_assign_set_rhs_from_tree(gsi, selected_val);
+                lowered_count++;
+                if (opt_trace)
+                    inform(gimple_location(stmt), "ternary: simplified constant conditional to %s", cond_zero ? "false" : "true");
+                return;
+            }
+        }
+
+        // Simplify if true_val == false_val
+        if (operand_equal_p(true_val, false_val, 0)) {
+            gimple_assign_set_rhs_from_tree(gsi, true_val);
+            lowered_count++;
+            if (opt_trace)
+                inform(gimple_location(stmt), "ternary: simplified conditional with equal branches");
+            return;
+        }
+
+        tree result_type = TREE_TYPE(lhs);
+        if (!ternary_select_lowered_p(result_type, cond)) {
+            if (opt_trace)
+                inform(gimple_location(stmt), "ternary: kept native conditional operator");
+            return;
+        }
+
+        if (ternary_select_can_inline(result_type, cond)) {
+            cond = ternary_select_flag(cond, gsi);
+            gimple_assign_set_rhs_with_ops(gsi, COND_EXPR, cond, true_val, false_val);
+            lowered_count++;
+            if (opt_trace)
+                inform(gimple_location(stmt), "ternary: kept conditional operator inline");
+            return;
+        }
+
+        tree cond_arg = cond;
+        tree cond_type = TREE_TYPE(cond);
+        if (get_ternary_type_trits(cond_type, nullptr)) {
+            cond = ternary_truth_flag(cond, gsi);
+            cond_arg = ternary_emit_op(gsi, long_long_integer_type_node, NOP_EXPR, cond, NULL_TREE);
+        }
+
+        // With -late a select producing a ternary value stays a COND_EXPR for
+        // the SSA optimizers; only the packed operands and the truth value of
+        // a ternary condition are committed here.
+        if (opt_late && !late_instance && get_ternary_type_trits(result_type, nullptr)) {
+            gimple_assign_set_rhs_with_ops(gsi, COND_EXPR, cond, true_val, false_val);
+            if (opt_trace)
+                inform(gimple_location(stmt), "ternary: deferred conditional operator to late lowering");
+            return;
+        }
+
+        if (cond_arg == cond && !types_compatible_p(cond_type, long_long_integer_type_node)) {
+            if (late_instance) {
+                // SSA call arguments must be plain values, so the condition
+                // is converted by statements of its own.
+                if (COMPARISON_CLASS_P(cond)) {
+                    tree flag = make_ssa_name(boolean_type_node);
+                    gsi_insert_before(gsi, gimple_build_assign(flag, cond), GSI_SAME_STMT);
+                    cond = flag;
+                }
+                cond_arg = make_ssa_name(long_long_integer_type_node);
+                gsi_insert_before(gsi, gimple_build_assign(cond_arg, NOP_EXPR, cond), GSI_SAME_STMT);
+            } else {
+                cond_arg = fold_convert(long_long_integer_type_node, cond);
+            }
+        }
+
+        tree decl = get_select_decl(result_type, cond_type);
+        if (!decl) {
+            surviving_count++;
+            return;
+        }
+
+        gcall *call = gimple_build_call(decl, 3, cond_arg, true_val, false_val);
+        gimple_call_set_lhs(call, lhs);
+        gsi_replace(gsi, call, true);
+        lowered_count++;
+        if (opt_trace)
+            inform(gimple_location(stmt), "ternary: lowered conditional operator");
+    }
+
+    // Only selects on ternary values are left for this instance; everything
+    // else was lowered to helper calls before SSA.
+    unsigned int execute_late(function *fun)
+    {
+        basic_block bb;
+        FOR_EACH_BB_FN(bb, fun)
+        {
+            for (gimple_stmt_iterator gsi = gsi_start_bb(bb); !gsi_end_p(gsi); gsi_next(&gsi))
+            {
+                gimple *stmt = gsi_stmt(gsi);
+                if (is_gimple_assign(stmt) && gimple_assign_rhs_code(stmt) == COND_EXPR &&
+                    get_ternary_type_trits(TREE_TYPE(gimple_assign_lhs(stmt)), nullptr))
+                    lower_select_stmt(&gsi, stmt);
+            }
+        }
+        lowered_count += ternary_fold_helper_calls(fun);
+        conversion_count += ternary_cancel_conversions(fun);
         return 0;
     }
 };
 } // namespace
 
+// -inline takes a comma-separated list of ternary_inline_classes names;
+// without a value it enables all of them.
+static void parse_inline_classes(const char *value)
+{
+    if (!value) {
+        opt_inline = TERNARY_INLINE_ALL;
+        return;
+    }
+
+    std::string list(value);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos)
+            end = list.size();
+        const std::string item = list.substr(start, end - start);
+        start = end + 1;
+        if (item.empty())
+            continue;
+
+        bool known = false;
+        for (const auto &cls : ternary_inline_classes) {
+            if (item == cls.name) {
+                opt_inline |= cls.mask;
+                known = true;
+                break;
+            }
+        }
+        if (!known)
+            warning(0, "unknown ternary inline class '%s'", item.c_str());
+    }
+}
+
 static void parse_args(struct plugin_name_args *plugin_info)
 {
     for (int i = 0; i < plugin_info->argc; ++i)
@@ -1835,8 +4404,28 @@ static void parse_args(struct plugin_name_args *plugin_info)
             opt_trace = true;
         else if (!strcmp(key, "dump-gimple"))
             opt_dump_gimple = true;
+        else if (!strcmp(key, "inline"))
+            parse_inline_classes(value);
+        else if (!strcmp(key, "inline-cmp"))
+            opt_inline |= TERNARY_INLINE_CMP;
+        else if (!strcmp(key, "inline-shift"))
+            opt_inline |= TERNARY_INLINE_SHIFT;
+        else if (!strcmp(key, "late"))
+            opt_late = true;
+        else if (!strcmp(key, "region"))
+            opt_region = true;
         else if (!strcmp(key, "prefix") && value)
             opt_prefix = value;
+        else if (!strcmp(key, "select") && value) {
+            if (!strcmp(value, "ternary-only"))
+                opt_select = TERNARY_SELECT_TERNARY_ONLY;
+            else if (!strcmp(value, "profitable"))
+                opt_select = TERNARY_SELECT_PROFITABLE;
+            else if (!strcmp(value, "all"))
+                opt_select = TERNARY_SELECT_ALL;
+            else
+                warning(0, "unknown ternary select policy '%s'", value);
+        }
         else
             warning(0, "unknown plugin argument '%s'", key);
     }
@@ -1847,6 +4436,7 @@ static void ternary_plugin_init(void *gcc_data, void *user_data)
     (void)gcc_data;
     (void)user_data;
 
+    ternary_init_builtin_table();
     if (!opt_types)
         return;
 
@@ -1864,9 +4454,14 @@ static void ternary_plugin_init(void *gcc_data, void *user_data)
 
 static void ternary_plugin_finish(void *, void *)
 {
-    if (opt_stats)
-        inform(UNKNOWN_LOCATION, "ternary plugin: %lu ternary ops, %lu lowered, %lu surviving gimple ops",
-               ternary_count, lowered_count, surviving_count);
+    if (!opt_stats)
+        return;
+    inform(UNKNOWN_LOCATION, "ternary plugin: %lu ternary ops, %lu lowered, %lu surviving gimple ops, %lu rewrites, %lu conversions removed",
+           ternary_count, lowered_count, surviving_count, rewrite_count, conversion_count);
+    for (unsigned i = 0; i < ARRAY_SIZE(ternary_rewrite_rules); ++i)
+        if (ternary_rewrite_hits[i])
+            inform(UNKNOWN_LOCATION, "ternary plugin:   %-20s %lu", ternary_rewrite_rules[i].text,
+                   ternary_rewrite_hits[i]);
 }
 
 extern "C" int plugin_init(struct plugin_name_args *plugin_info, struct plugin_gcc_version *version)
@@ -1911,5 +4506,14 @@ extern "C" int plugin_init(struct plugin_name_args *plugin_info, struct plugin_g
     pass_info.pos_op = PASS_POS_INSERT_AFTER;
     register_callback(plugin_info->base_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &pass_info);
 
+    if (opt_late) {
+        register_pass_info late_pass_info;
+        late_pass_info.pass = new ternary_pass(true);
+        late_pass_info.reference_pass_name = "optimized";
+        late_pass_info.ref_pass_instance_number = 1;
+        late_pass_info.pos_op = PASS_POS_INSERT_AFTER;
+        register_callback(plugin_info->base_name, PLUGIN_PASS_MANAGER_SETUP, NULL, &late_pass_info);
+    }
+
     return 0;
 }
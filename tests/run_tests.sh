@@ -29,6 +29,10 @@ cd .. && make && cd tests
 echo "Testing lowering..."
 $GCC -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower -I../include -c test_ternary.c -o test_lower.o
 
+echo "Testing select policy..."
+$GCC -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower -fplugin-arg-ternary_plugin-select=all \
+     -I../include -c test_ternary.c -o test_select_all.o
+
 echo "Testing arithmetic..."
 $GCC -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-arith -I../include -c test_ternary.c -o test_arith.o
 
@@ -54,4 +58,75 @@ echo "Testing gimple/dump features..."
 $GCC -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower \
      -fplugin-arg-ternary_plugin-dump-gimple -I../include -c test_ternary.c -o test_dump.o
 
+echo "Testing lowered code links and runs..."
+$GCC -O2 -I../include -c ../runtime/ternary_runtime.c -o ternary_runtime.o
+$GCC -O2 -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower -I../include \
+     test_lowering_link.c ternary_runtime.o -o test_lowering_link && ./test_lowering_link || exit 1
+
+echo "Testing select policies on lowered code..."
+for policy in ternary-only profitable; do
+    $GCC -O2 -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower -fplugin-arg-ternary_plugin-select=$policy \
+         -I../include -c test_lowering_link.c -o test_select_$policy.o || exit 1
+    if nm -u test_select_$policy.o | grep -q '__ternary_select_i32'; then
+        echo "int select lowered under -select=$policy"
+        exit 1
+    fi
+    $GCC -O2 test_select_$policy.o ternary_runtime.o -o test_select_$policy && ./test_select_$policy || exit 1
+done
+
+echo "Testing late select lowering..."
+$GCC -O2 -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower -fplugin-arg-ternary_plugin-late \
+     -I../include test_lowering_link.c ternary_runtime.o -o test_lowering_late && \
+     ./test_lowering_late || exit 1
+
+echo "Testing inline expansion..."
+$GCC -O2 -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower -fplugin-arg-ternary_plugin-inline=all \
+     -I../include test_lowering_link.c ternary_runtime.o -o test_lowering_inline && \
+     ./test_lowering_inline || exit 1
+
+echo "Testing binary regions..."
+$GCC -O2 -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower -fplugin-arg-ternary_plugin-region \
+     -I../include test_lowering_link.c ternary_runtime.o -o test_lowering_region && \
+     ./test_lowering_region || exit 1
+
+echo "Testing identity rewrite counters..."
+$GCC -O2 -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower -fplugin-arg-ternary_plugin-stats \
+     -I../include -c test_lowering_link.c -o test_lowering_stats.o 2> test_lowering_stats.log || exit 1
+for rule in '-(-a) -> a' 'tnot(tnot a) -> a'; do
+    if [ "$(grep -F -- "$rule" test_lowering_stats.log | awk '{print $NF}')" != 4 ]; then
+        echo "Expected 4 rewrites of $rule"
+        exit 1
+    fi
+done
+
+echo "Testing constant helper folding..."
+$GCC -O2 -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower -I../include \
+     -c test_fold_link.c -o test_fold_link.o || exit 1
+if nm -u test_fold_link.o | grep -E '__ternary_(bt_str|tb2t|txor|tequiv|tmux|tround)_t'; then
+    echo "Constant helper calls were not folded"
+    exit 1
+fi
+$GCC -O2 test_fold_link.o ternary_runtime.o -o test_fold_link && ./test_fold_link || exit 1
+
+echo "Testing helper call merging..."
+$GCC -O2 -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-lower -fplugin-arg-ternary_plugin-arith \
+     -fdump-tree-optimized=test_helper_cse.optimized -I../include -c test_helper_cse.c \
+     -o test_helper_cse.o || exit 1
+if [ "$(grep -c '__ternary_add_t32 (' test_helper_cse.optimized)" != 2 ]; then
+    echo "Repeated add_t32 calls were not merged"
+    exit 1
+fi
+
+echo "Testing builtin lowering..."
+$GCC -O2 -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-arith -fplugin-arg-ternary_plugin-cmp \
+     -I../include -c test_builtin_link.c -o test_builtin_link.o || exit 1
+if nm -u test_builtin_link.o | grep '__builtin_ternary_'; then
+    echo "Builtin calls were not lowered"
+    exit 1
+fi
+$GCC -O2 test_builtin_link.o ternary_runtime.o -o test_builtin_link && ./test_builtin_link || exit 1
+$GCC -O2 -fplugin=$PLUGIN -fplugin-arg-ternary_plugin-arith -fplugin-arg-ternary_plugin-cmp \
+     -fplugin-arg-ternary_plugin-inline=select -I../include test_builtin_link.c ternary_runtime.o \
+     -o test_builtin_inline && ./test_builtin_inline || exit 1
+
 echo "All plugin tests compiled successfully."
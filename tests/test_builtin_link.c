@@ -0,0 +1,65 @@
+// Builtin lowering link test for Ternary GCC Plugin
+// Each __builtin_ternary_* call below is only declared here; the plugin
+// replaces it with the runtime helper for its type, and with -inline=select
+// expands the select in place. Most builtins are used twice, so the second
+// call reuses the registered decl. run_tests.sh checks that no builtin is
+// left undefined, then runs the test against the runtime.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "ternary_plugin.h"
+#include "ternary_runtime.h"
+
+extern t32_t __builtin_ternary_add(t32_t a, t32_t b);
+extern t32_t __builtin_ternary_sub(t32_t a, t32_t b);
+extern t32_t __builtin_ternary_mul(t32_t a, t32_t b);
+extern int __builtin_ternary_neg(int a);
+extern int __builtin_ternary_lt(int a, int b);
+extern t32_t __builtin_ternary_select(t32_t cond, t32_t a, t32_t b);
+
+static int fail_count = 0;
+
+static void expect_i64(const char *name, int64_t got, int64_t expect)
+{
+    if (got != expect) {
+        fprintf(stderr, "FAIL %s: got %" PRId64 " expect %" PRId64 "\n", name, got, expect);
+        fail_count++;
+    }
+}
+
+t32_t add_twice_t32(t32_t a, t32_t b) { return __builtin_ternary_add(__builtin_ternary_add(a, b), b); }
+t32_t mul_sub_t32(t32_t a, t32_t b) { return __builtin_ternary_sub(__builtin_ternary_mul(a, b), a); }
+t32_t square_t32(t32_t a) { return __builtin_ternary_mul(a, a); }
+int neg_int(int a) { return __builtin_ternary_neg(a); }
+int neg_neg_int(int a) { return __builtin_ternary_neg(__builtin_ternary_neg(a)); }
+int lt_int(int a, int b) { return __builtin_ternary_lt(a, b); }
+t32_t select_t32(t32_t c, t32_t a, t32_t b) { return __builtin_ternary_select(c, a, b); }
+
+int main(void)
+{
+    const t32_t a = __ternary_tb2t_t32(-12);
+    const t32_t b = __ternary_tb2t_t32(5);
+    expect_i64("add_twice_t32", __ternary_tt2b_t32(add_twice_t32(a, b)), -2);
+    expect_i64("mul_sub_t32", __ternary_tt2b_t32(mul_sub_t32(a, b)), -48);
+    expect_i64("square_t32", __ternary_tt2b_t32(square_t32(a)), 144);
+    expect_i64("neg_int", neg_int(7), -7);
+    expect_i64("neg_neg_int", neg_neg_int(-7), -7);
+    expect_i64("lt_int", lt_int(-3, 2), 1);
+    expect_i64("lt_int_not", lt_int(2, -3), 0);
+
+    // A select condition is true unless its word is the packed zero; a
+    // reserved 11 code reads as +1, so such a word is true as well.
+    const uint64_t conds[] = {0x5555555555555555ULL, 0x5555555555555556ULL,
+                              0x5555555555555554ULL, 0x5555555555555557ULL,
+                              0x9555555555555555ULL, 0x0000000000000000ULL};
+    for (unsigned i = 0; i < sizeof conds / sizeof conds[0]; ++i)
+        expect_i64("select_t32", __ternary_tt2b_t32(select_t32(conds[i], a, b)),
+                   conds[i] == 0x5555555555555555ULL ? 5 : -12);
+
+    if (fail_count == 0) {
+        printf("builtin lowering link tests passed\n");
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,97 @@
+// Constant-folding link test for Ternary GCC Plugin
+// Every helper call below has constant arguments, so the plugin replaces it
+// with the word the runtime would return. run_tests.sh checks that none of
+// these helpers is still referenced, then runs the test against the runtime.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "ternary_plugin.h"
+#include "ternary_runtime.h"
+
+// Packed t32 words, as the helpers take them: 00 = -1, 01 = 0, 10 = +1.
+#define P32_ZERO 0x5555555555555555ULL
+#define P32_ONE 0x5555555555555556ULL
+#define P32_MINUS_ONE 0x5555555555555554ULL
+#define P32_FIVE 0x5555555555555560ULL
+#define P32_SIX 0x5555555555555561ULL
+#define P32_SEVEN 0x5555555555555562ULL
+#define P32_MINUS_EIGHT 0x5555555555555546ULL
+#define P32_MINUS_26 0x5555555555555516ULL
+
+static int fail_count = 0;
+
+static void expect_i64(const char *name, int64_t got, int64_t expect)
+{
+    if (got != expect) {
+        fprintf(stderr, "FAIL %s: got %" PRId64 " expect %" PRId64 "\n", name, got, expect);
+        fail_count++;
+    }
+}
+
+t32_t literal_t32(void) { return T32_LITERAL("1 0 -1"); }
+t64_t literal_t64(void) { return T64_LITERAL("1,-1,1"); }
+t32_t bt_str_t32(void) { return __ternary_bt_str_t32("+1 -1 -1 0"); }
+t32_t tb2t_t32(void) { return __ternary_tb2t_t32(-42); }
+t64_t tb2t_t64(void) { return __ternary_tb2t_t64(6078832729528464400LL); }
+t32_t txor_t32(void) { return __ternary_txor_t32(P32_ONE, P32_ZERO); }
+t32_t txor_same_t32(void) { return __ternary_txor_t32(P32_MINUS_ONE, P32_MINUS_ONE); }
+t32_t tequiv_t32(void) { return __ternary_tequiv_t32(P32_ONE, P32_MINUS_ONE); }
+t32_t tmux_neg_t32(void)
+{
+    return __ternary_tmux_t32(P32_MINUS_EIGHT, P32_FIVE, P32_SIX, P32_SEVEN);
+}
+t32_t tmux_zero_t32(void) { return __ternary_tmux_t32(P32_ZERO, P32_FIVE, P32_SIX, P32_SEVEN); }
+t32_t tround_t32(void) { return __ternary_tround_t32(P32_MINUS_26, 2); }
+t32_t tround_all_t32(void) { return __ternary_tround_t32(P32_MINUS_EIGHT, 40); }
+
+// t64 literals at and just past (3^40 - 1) / 2, where packing used to give
+// up, fold exactly; so does a sum that crosses it.
+#define B40 6078832729528464400LL
+t64_t bound_t64(void) { return B40; }
+t64_t neg_bound_t64(void) { return -B40; }
+t64_t past_bound_t64(void) { return B40 + 1; }
+t64_t neg_past_bound_t64(void) { return -B40 - 1; }
+t64_t bound_sum_t64(void)
+{
+    t64_t b = B40;
+    t64_t one = 1;
+    return b + one;
+}
+
+// Past the 64-trit bound the wrapping helpers take over: max + 1 is -max.
+t64_t inc_t64(t64_t a) { return a + 1; }
+t64_t dec_t64(t64_t a) { return a - 1; }
+
+int main(void)
+{
+    expect_i64("literal_t32", __ternary_tt2b_t32(literal_t32()), 8);
+    expect_i64("literal_t64", __ternary_tt2b_t64(literal_t64()), 7);
+    expect_i64("bt_str_t32", __ternary_tt2b_t32(bt_str_t32()), 15);
+    expect_i64("tb2t_t32", __ternary_tt2b_t32(tb2t_t32()), -42);
+    expect_i64("tb2t_t64", __ternary_tt2b_t64(tb2t_t64()), 6078832729528464400LL);
+    expect_i64("txor_t32", __ternary_tt2b_t32(txor_t32()), 1);
+    expect_i64("txor_same_t32", __ternary_tt2b_t32(txor_same_t32()), -1);
+    expect_i64("tequiv_t32", __ternary_tt2b_t32(tequiv_t32()), -1);
+    expect_i64("tmux_neg_t32", __ternary_tt2b_t32(tmux_neg_t32()), 5);
+    expect_i64("tmux_zero_t32", __ternary_tt2b_t32(tmux_zero_t32()), 6);
+    expect_i64("tround_t32", __ternary_tt2b_t32(tround_t32()), -2);
+    expect_i64("tround_all_t32", __ternary_tt2b_t32(tround_all_t32()), 0);
+    expect_i64("bound_t64", __ternary_tt2b_t64(bound_t64()), B40);
+    expect_i64("neg_bound_t64", __ternary_tt2b_t64(neg_bound_t64()), -B40);
+    expect_i64("past_bound_t64", __ternary_tt2b_t64(past_bound_t64()), B40 + 1);
+    expect_i64("neg_past_bound_t64", __ternary_tt2b_t64(neg_past_bound_t64()), -B40 - 1);
+    expect_i64("bound_sum_t64", __ternary_tt2b_t64(bound_sum_t64()), B40 + 1);
+    // Kept out of t64_t so the raw word is not read as a logical literal.
+    const unsigned __int128 max64 = (unsigned __int128)0xAAAAAAAAAAAAAAAAULL << 64 |
+                                    0xAAAAAAAAAAAAAAAAULL;
+    const t64_t min64 = __ternary_neg_t64(max64);
+    expect_i64("inc_max_t64", __ternary_cmp_t64(inc_t64(max64), min64), 0);
+    expect_i64("dec_min_t64", __ternary_cmp_t64(dec_t64(min64), max64), 0);
+
+    if (fail_count == 0) {
+        printf("constant folding link tests passed\n");
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,16 @@
+// Helper CSE test for Ternary GCC Plugin
+// The lowered helpers are declared const, so GCC merges repeated calls with
+// the same arguments. run_tests.sh counts the add_t32 calls left in the
+// optimized dump: one per function.
+
+#include "ternary_plugin.h"
+
+t32_t square_sum_t32(t32_t a, t32_t b) { return (a + b) * (a + b); }
+
+t32_t sum_or_product_t32(t32_t a, t32_t b, int up)
+{
+    t32_t s = a + b;
+    if (up)
+        return s;
+    return (a + b) * b;
+}
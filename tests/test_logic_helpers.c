@@ -44,7 +44,9 @@ int main(void)
 
     expect_int("tequiv_same", __ternary_tt2b_t32(__ternary_tequiv_t32(pos, pos)), 1);
     expect_int("tequiv_unknown", __ternary_tt2b_t32(__ternary_tequiv_t32(pos, zero)), 0);
-    expect_int("tnet_simple", __ternary_tnet_t32(__ternary_tb2t_t32(2)), 2);
+    /* tnet counts trits: 4 is ++ (net 2), 2 is +- (net 0). */
+    expect_int("tnet_simple", __ternary_tnet_t32(__ternary_tb2t_t32(4)), 2);
+    expect_int("tnet_cancel", __ternary_tnet_t32(__ternary_tb2t_t32(2)), 0);
     expect_int("tmux_select", __ternary_tt2b_t32(__ternary_tmux_t32(__ternary_tb2t_t32(-1),
                                                                   __ternary_tb2t_t32(-4),
                                                                   __ternary_tb2t_t32(0),
@@ -70,6 +72,7 @@ int main(void)
     expect_int("tinv alias", __ternary_tt2b_t32(__ternary_tinv_t32(__ternary_tb2t_t32(-5))), 5);
 
     expect_int("tround", __ternary_tt2b_t32(__ternary_tround_t32(__ternary_tb2t_t32(8), 1)), 2);
+    expect_int("tround_all", __ternary_tt2b_t32(__ternary_tround_t32(__ternary_tb2t_t32(-8), 32)), 0);
     expect_int("tnormalize", __ternary_tt2b_t32(__ternary_tnormalize_t32(0xFFFFFFFFFFFFFFFFULL)), 0);
     expect_int("tbias", __ternary_tt2b_t32(__ternary_tbias_t32(__ternary_tb2t_t32(1), 3)), 4);
 
@@ -85,7 +88,10 @@ int main(void)
                                                                       __ternary_tb2t_t64(1))), 1);
     expect_int("txor_t64_diff", __ternary_tt2b_t64(__ternary_txor_t64(__ternary_tb2t_t64(1),
                                                                     __ternary_tb2t_t64(-1))), 0);
-    expect_int("tnet_t64", __ternary_tnet_t64(__ternary_tb2t_t64(2)), 2);
+    expect_int("tnet_t64", __ternary_tnet_t64(__ternary_tb2t_t64(4)), 2);
+    t64_t top_pair = __ternary_shl_t64(__ternary_tb2t_t64(4), 62);
+    expect_int("tnet_t64_wide", __ternary_tnet_t64(__ternary_neg_t64(top_pair)), -2);
+    expect_int("tsignjmp_t64_wide", __ternary_tsignjmp_t64(__ternary_neg_t64(top_pair), -1, 0, 1), -1);
     expect_int("tmux_t64_select", __ternary_tt2b_t64(__ternary_tmux_t64(__ternary_tb2t_t64(0),
                                                                       __ternary_tb2t_t64(-3),
                                                                       __ternary_tb2t_t64(0),
@@ -100,11 +106,16 @@ int main(void)
                                                                        __ternary_tb2t_t128(0))), 1);
     expect_int("t128_txor_same", __ternary_tt2b_t128(__ternary_txor_t128(__ternary_tb2t_t128(1),
                                                                        __ternary_tb2t_t128(1))), -1);
-    expect_int("t128_tnet", __ternary_tnet_t128(__ternary_tb2t_t128(3)), 3);
+    expect_int("t128_tnet", __ternary_tnet_t128(__ternary_tb2t_t128(13)), 3);
     expect_int("t128_tmux_pos", __ternary_tt2b_t128(__ternary_tmux_t128(__ternary_tb2t_t128(1),
                                                                        __ternary_tb2t_t128(-2),
                                                                        __ternary_tb2t_t128(0),
                                                                        __ternary_tb2t_t128(4))), 4);
+    expect_int("t128_tmuladd", __ternary_tt2b_t128(__ternary_tmuladd_t128(__ternary_tb2t_t128(2),
+                                                                        __ternary_tb2t_t128(-5),
+                                                                        __ternary_tb2t_t128(4))), -6);
+    expect_int("t128_tround", __ternary_tt2b_t128(__ternary_tround_t128(__ternary_tb2t_t128(-26), 2)), -2);
+    expect_int("t128_tround_all", __ternary_tt2b_t128(__ternary_tround_t128(__ternary_tb2t_t128(-26), 128)), 0);
 #endif
 
     expect_int("tequiv_true", __ternary_tt2b_t32(__ternary_tequiv_t32(pos, pos)), 1);
@@ -0,0 +1,282 @@
+// Lowered-code link test for Ternary GCC Plugin
+// Every helper the plugin emits here must be defined by the runtime, and the
+// lowered code must compute the same values as the helpers called directly.
+// Built by run_tests.sh with the plugin and linked against the runtime.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "ternary_runtime.h"
+
+static int fail_count = 0;
+
+static void expect_i64(const char *name, int64_t got, int64_t expect)
+{
+    if (got != expect) {
+        fprintf(stderr, "FAIL %s: got %" PRId64 " expect %" PRId64 "\n", name, got, expect);
+        fail_count++;
+    }
+}
+
+// Selects and compares on ternary values; -late keeps the selects as
+// conditional operators until the ternary_late pass.
+t32_t pick_t32(t32_t c, t32_t a, t32_t b) { return c ? a : b; }
+t64_t pick_t64(t64_t c, t64_t a, t64_t b) { return c ? a : b; }
+int pick_int(int c, int a, int b) { return c ? a : b; }
+int less_t32(t32_t a, t32_t b) { return a < b; }
+int less_t64(t64_t a, t64_t b) { return a < b; }
+
+// Negation, tnot, tmin, tmax and constant shifts; -inline=all expands them
+// as word operations for t32 and t64, while t128 always calls the helpers.
+t32_t logic_t32(t32_t a, t32_t b) { return ((-a & b) | (~b << 2)) >> 1; }
+t64_t logic_t64(t64_t a, t64_t b) { return ((-a & b) | (~b << 2)) >> 1; }
+
+// An arithmetic chain; -region evaluates the t32 one in native integers.
+t32_t chain_t32(t32_t a, t32_t b, t32_t c, t32_t e) { return (a * b + c - e) / 4 % 5; }
+t64_t chain_t64(t64_t a, t64_t b, t64_t c, t64_t e) { return (a * b + c - e) / 4 % 5; }
+
+// Fused into __ternary_tmuladd_tN.
+t32_t muladd_t32(t32_t a, t32_t b, t32_t c) { return a * b + c; }
+t64_t muladd_t64(t64_t a, t64_t b, t64_t c) { return a * b + c; }
+
+// Dividing by a power of three becomes __ternary_tround_tN.
+t32_t div9_t32(t32_t a) { return a / 9; }
+t64_t div9_t64(t64_t a) { return a / 9; }
+
+// Loop counters that run as native integers.
+int count_to_t32(t32_t n)
+{
+    int steps = 0;
+    for (t32_t i = 0; i < n; i = i + 1)
+        steps++;
+    return steps;
+}
+
+t32_t last_t32(t32_t n)
+{
+    t32_t i;
+    for (i = 0; i < n; i = i + 3)
+        ;
+    return i;
+}
+
+// Stepping past the largest t32 value wraps to the smallest one.
+int wrap_t32(void)
+{
+    int steps = 0;
+    for (t32_t i = 926510094425920; i != -926510094425920; i = i + 1)
+        steps++;
+    return steps;
+}
+
+// A compare ladder on two ternary operands becomes one cmp and a switch.
+int ladder_t32(t32_t a, t32_t b)
+{
+    if (a < b)
+        return -10;
+    else if (a == b)
+        return 0;
+    return 10;
+}
+
+int ladder_t64(t64_t a, t64_t b)
+{
+    if (a < b)
+        return -10;
+    else if (a == b)
+        return 0;
+    return 10;
+}
+
+// Sign tests compare the order against the packed zero. Selecting by it
+// becomes tmux, branching on it a switch.
+#define PACKED_ZERO_T32 0x5555555555555555ULL
+#define PACKED_ZERO_T64 ((t64_t)PACKED_ZERO_T32 << 64 | PACKED_ZERO_T32)
+
+t32_t by_sign_t32(t32_t s, t32_t x, t32_t y, t32_t z)
+{
+    int c = __ternary_cmp_t32(s, PACKED_ZERO_T32);
+    return c < 0 ? x : c == 0 ? y : z;
+}
+
+t64_t by_sign_t64(t64_t s, t64_t x, t64_t y, t64_t z)
+{
+    int c = __ternary_cmp_t64(PACKED_ZERO_T64, s);
+    return c > 0 ? x : c == 0 ? y : z;
+}
+
+int sign_branch_t32(t32_t s)
+{
+    int c = __ternary_cmp_t32(s, PACKED_ZERO_T32);
+    if (c < 0)
+        return 1;
+    else if (c == 0)
+        return 2;
+    return 3;
+}
+
+// Double negations split across statements, which the front end does not
+// fold; the identity rewrites remove both. - and ~ are both negation.
+t32_t neg_neg_t32(t32_t a) { t32_t n = -a; return -n; }
+t32_t not_not_t32(t32_t a) { t32_t n = ~a; return ~n; }
+t32_t not_neg_t32(t32_t a) { t32_t n = -a; return ~n; }
+t32_t neg_not_t32(t32_t a) { t32_t n = ~a; return -n; }
+t64_t neg_neg_t64(t64_t a) { t64_t n = -a; return -n; }
+t64_t not_not_t64(t64_t a) { t64_t n = ~a; return ~n; }
+t64_t not_neg_t64(t64_t a) { t64_t n = -a; return ~n; }
+t64_t neg_not_t64(t64_t a) { t64_t n = ~a; return -n; }
+
+// Conversion round trips the plugin removes. A word may hold reserved 11
+// codes, which read as +1; the trip back gives the canonical word.
+int int_trip_t32(int i) { return (int)__ternary_tt2b_t32(__ternary_tb2t_t32(i)); }
+long long int_trip_t64(long long i) { return __ternary_tt2b_t64(__ternary_tb2t_t64(i)); }
+t32_t word_trip_t32(t32_t t) { return __ternary_tb2t_t32(__ternary_tt2b_t32(t)); }
+t32_t shl_t32(t32_t a) { return a << 3; }
+t32_t shr_t32(t32_t a) { return a >> 3; }
+t32_t rol_t32(t32_t a) { return __ternary_rol_t32(a, 5); }
+t32_t ror_t32(t32_t a) { return __ternary_ror_t32(a, 5); }
+
+#if defined(__BITINT_MAXWIDTH__) && __BITINT_MAXWIDTH__ >= 256 && !defined(__cplusplus)
+t128_t pick_t128(t128_t c, t128_t a, t128_t b) { return c ? a : b; }
+int less_t128(t128_t a, t128_t b) { return a < b; }
+t128_t logic_t128(t128_t a, t128_t b) { return ((-a & b) | (~b << 2)) >> 1; }
+t128_t chain_t128(t128_t a, t128_t b, t128_t c, t128_t e) { return (a * b + c - e) / 4 % 5; }
+t128_t muladd_t128(t128_t a, t128_t b, t128_t c) { return a * b + c; }
+t128_t div9_t128(t128_t a) { return a / 9; }
+#endif
+
+int main(void)
+{
+    expect_i64("pick_t32_true", __ternary_tt2b_t32(pick_t32(__ternary_tb2t_t32(-1),
+                                                            __ternary_tb2t_t32(5),
+                                                            __ternary_tb2t_t32(-7))), 5);
+    expect_i64("pick_t32_false", __ternary_tt2b_t32(pick_t32(__ternary_tb2t_t32(0),
+                                                             __ternary_tb2t_t32(5),
+                                                             __ternary_tb2t_t32(-7))), -7);
+    expect_i64("pick_t64_true", __ternary_tt2b_t64(pick_t64(__ternary_tb2t_t64(2),
+                                                            __ternary_tb2t_t64(5),
+                                                            __ternary_tb2t_t64(-7))), 5);
+    expect_i64("pick_int_true", pick_int(-1, 5, -7), 5);
+    expect_i64("pick_int_false", pick_int(0, 5, -7), -7);
+    expect_i64("less_t32", less_t32(__ternary_tb2t_t32(-3), __ternary_tb2t_t32(2)), 1);
+    expect_i64("less_t32_not", less_t32(__ternary_tb2t_t32(4), __ternary_tb2t_t32(-4)), 0);
+    expect_i64("less_t64", less_t64(__ternary_tb2t_t64(-3), __ternary_tb2t_t64(2)), 1);
+    t32_t a32 = __ternary_tb2t_t32(5), b32 = __ternary_tb2t_t32(-7);
+    expect_i64("logic_t32", __ternary_tt2b_t32(logic_t32(a32, b32)),
+               __ternary_tt2b_t32(__ternary_shr_t32(
+                   __ternary_or_t32(__ternary_and_t32(__ternary_neg_t32(a32), b32),
+                                    __ternary_shl_t32(__ternary_not_t32(b32), 2)), 1)));
+    t64_t a64 = __ternary_tb2t_t64(5), b64 = __ternary_tb2t_t64(-7);
+    expect_i64("logic_t64", __ternary_tt2b_t64(logic_t64(a64, b64)),
+               __ternary_tt2b_t64(__ternary_shr_t64(
+                   __ternary_or_t64(__ternary_and_t64(__ternary_neg_t64(a64), b64),
+                                    __ternary_shl_t64(__ternary_not_t64(b64), 2)), 1)));
+    const t32_t four32 = __ternary_tb2t_t32(4), five32 = __ternary_tb2t_t32(5);
+    const int64_t chain_in[][4] = {{123456, -789, 1000, -77},
+                                   {900000000000, 1000, 3, 926510094425920}};
+    for (unsigned i = 0; i < sizeof chain_in / sizeof chain_in[0]; ++i) {
+        t32_t x[4];
+        t64_t y[4];
+        for (unsigned j = 0; j < 4; ++j) {
+            x[j] = __ternary_tb2t_t32(chain_in[i][j]);
+            y[j] = __ternary_tb2t_t64(chain_in[i][j]);
+        }
+        expect_i64("chain_t32", __ternary_tt2b_t32(chain_t32(x[0], x[1], x[2], x[3])),
+                   __ternary_tt2b_t32(__ternary_mod_t32(__ternary_div_t32(
+                       __ternary_sub_t32(__ternary_add_t32(__ternary_mul_t32(x[0], x[1]), x[2]),
+                                         x[3]), four32), five32)));
+        expect_i64("chain_t64", __ternary_tt2b_t64(chain_t64(y[0], y[1], y[2], y[3])),
+                   __ternary_tt2b_t64(__ternary_mod_t64(__ternary_div_t64(
+                       __ternary_sub_t64(__ternary_add_t64(__ternary_mul_t64(y[0], y[1]), y[2]),
+                                         y[3]), __ternary_tb2t_t64(4)), __ternary_tb2t_t64(5))));
+    }
+    expect_i64("muladd_t32",
+               __ternary_tt2b_t32(muladd_t32(__ternary_tb2t_t32(7), __ternary_tb2t_t32(-5),
+                                             __ternary_tb2t_t32(3))), -32);
+    expect_i64("muladd_t64",
+               __ternary_tt2b_t64(muladd_t64(__ternary_tb2t_t64(7), __ternary_tb2t_t64(-5),
+                                             __ternary_tb2t_t64(3))), -32);
+    expect_i64("div9_t32", __ternary_tt2b_t32(div9_t32(__ternary_tb2t_t32(-26))), -2);
+    expect_i64("div9_t64", __ternary_tt2b_t64(div9_t64(__ternary_tb2t_t64(-26))), -2);
+    expect_i64("count_to_t32", count_to_t32(__ternary_tb2t_t32(10)), 10);
+    expect_i64("last_t32", __ternary_tt2b_t32(last_t32(__ternary_tb2t_t32(10))), 12);
+    expect_i64("wrap_t32", wrap_t32(), 1);
+    const int64_t sign_in[] = {-926510094425920, -3, 0, 1, 926510094425920};
+    for (unsigned i = 0; i < sizeof sign_in / sizeof sign_in[0]; ++i) {
+        const int64_t v = sign_in[i];
+        const int sign = (v > 0) - (v < 0);
+        const t32_t s32 = __ternary_tb2t_t32(v);
+        const t64_t s64 = __ternary_tb2t_t64(v);
+        expect_i64("ladder_t32", ladder_t32(s32, __ternary_tb2t_t32(1)),
+                   v < 1 ? -10 : v == 1 ? 0 : 10);
+        expect_i64("ladder_t64", ladder_t64(s64, __ternary_tb2t_t64(-3)),
+                   v < -3 ? -10 : v == -3 ? 0 : 10);
+        expect_i64("by_sign_t32", __ternary_tt2b_t32(by_sign_t32(s32, __ternary_tb2t_t32(-5),
+                                                                 __ternary_tb2t_t32(6),
+                                                                 __ternary_tb2t_t32(7))),
+                   sign < 0 ? -5 : sign == 0 ? 6 : 7);
+        expect_i64("by_sign_t64", __ternary_tt2b_t64(by_sign_t64(s64, __ternary_tb2t_t64(-5),
+                                                                 __ternary_tb2t_t64(6),
+                                                                 __ternary_tb2t_t64(7))),
+                   sign < 0 ? -5 : sign == 0 ? 6 : 7);
+        expect_i64("sign_branch_t32", sign_branch_t32(s32), sign + 2);
+    }
+    const int64_t identity_in[] = {-926510094425920, -7, 0, 2, 926510094425920};
+    for (unsigned i = 0; i < sizeof identity_in / sizeof identity_in[0]; ++i) {
+        const int64_t v = identity_in[i];
+        const t32_t a32 = __ternary_tb2t_t32(v);
+        const t64_t a64 = __ternary_tb2t_t64(v);
+        expect_i64("neg_neg_t32", __ternary_tt2b_t32(neg_neg_t32(a32)), v);
+        expect_i64("not_not_t32", __ternary_tt2b_t32(not_not_t32(a32)), v);
+        expect_i64("not_neg_t32", __ternary_tt2b_t32(not_neg_t32(a32)), v);
+        expect_i64("neg_not_t32", __ternary_tt2b_t32(neg_not_t32(a32)), v);
+        expect_i64("neg_neg_t64", __ternary_tt2b_t64(neg_neg_t64(a64)), v);
+        expect_i64("not_not_t64", __ternary_tt2b_t64(not_not_t64(a64)), v);
+        expect_i64("not_neg_t64", __ternary_tt2b_t64(not_neg_t64(a64)), v);
+        expect_i64("neg_not_t64", __ternary_tt2b_t64(neg_not_t64(a64)), v);
+    }
+    const int trip_in[] = {-2147483647 - 1, -42, 0, 1, 2147483647};
+    for (unsigned i = 0; i < sizeof trip_in / sizeof trip_in[0]; ++i) {
+        expect_i64("int_trip_t32", int_trip_t32(trip_in[i]), trip_in[i]);
+        expect_i64("int_trip_t64", int_trip_t64(trip_in[i] * 3LL), trip_in[i] * 3LL);
+    }
+    const uint64_t trip_words[] = {0x5555555555555555ULL, 0x5555555555555546ULL,
+                                   0x5555555555555557ULL, 0xD5555555555555F5ULL,
+                                   0xFFFFFFFFFFFFFFFFULL};
+    for (unsigned i = 0; i < sizeof trip_words / sizeof trip_words[0]; ++i) {
+        const uint64_t w = trip_words[i];
+        const uint64_t c = w ^ (w & w >> 1 & 0x5555555555555555ULL);
+        expect_i64("word_trip_t32", (int64_t)word_trip_t32(w), (int64_t)c);
+        expect_i64("shl_t32", (int64_t)shl_t32(w), (int64_t)(c << 6 | 0x15));
+        expect_i64("shr_t32", (int64_t)shr_t32(w),
+                   (int64_t)(c >> 6 | 0x5400000000000000ULL * (c >> 62)));
+        expect_i64("rol_t32", (int64_t)rol_t32(w), (int64_t)(c << 10 | c >> 54));
+        expect_i64("ror_t32", (int64_t)ror_t32(w), (int64_t)(c >> 10 | c << 54));
+    }
+
+#if defined(__BITINT_MAXWIDTH__) && __BITINT_MAXWIDTH__ >= 256 && !defined(__cplusplus)
+    expect_i64("pick_t128_false", __ternary_tt2b_t128(pick_t128(__ternary_tb2t_t128(0),
+                                                                __ternary_tb2t_t128(5),
+                                                                __ternary_tb2t_t128(-7))), -7);
+    expect_i64("less_t128", less_t128(__ternary_tb2t_t128(-3), __ternary_tb2t_t128(2)), 1);
+    t128_t a128 = __ternary_tb2t_t128(5), b128 = __ternary_tb2t_t128(-7);
+    expect_i64("logic_t128", __ternary_tt2b_t128(logic_t128(a128, b128)),
+               __ternary_tt2b_t128(__ternary_shr_t128(
+                   __ternary_or_t128(__ternary_and_t128(__ternary_neg_t128(a128), b128),
+                                     __ternary_shl_t128(__ternary_not_t128(b128), 2)), 1)));
+    expect_i64("chain_t128",
+               __ternary_tt2b_t128(chain_t128(__ternary_tb2t_t128(123456), __ternary_tb2t_t128(-789),
+                                              __ternary_tb2t_t128(1000), __ternary_tb2t_t128(-77))),
+               (123456LL * -789 + 1000 + 77) / 4 % 5);
+    expect_i64("muladd_t128",
+               __ternary_tt2b_t128(muladd_t128(__ternary_tb2t_t128(7), __ternary_tb2t_t128(-5),
+                                               __ternary_tb2t_t128(3))), -32);
+    expect_i64("div9_t128", __ternary_tt2b_t128(div9_t128(__ternary_tb2t_t128(-26))), -2);
+#endif
+
+    if (fail_count == 0) {
+        printf("lowered code link tests passed\n");
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "ternary_runtime.h"
+
+static int fail_count = 0;
+
+static void expect_i64(const char *name, int64_t got, int64_t expect)
+{
+    if (got != expect) {
+        fprintf(stderr, "FAIL %s: got %" PRId64 " expect %" PRId64 "\n", name, got, expect);
+        fail_count++;
+    }
+}
+
+static void expect_u64(const char *name, uint64_t got, uint64_t expect)
+{
+    if (got != expect) {
+        fprintf(stderr, "FAIL %s: got 0x%016" PRIx64 " expect 0x%016" PRIx64 "\n",
+                name, got, expect);
+        fail_count++;
+    }
+}
+
+static uint64_t xorshift_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t next_random(void)
+{
+    xorshift_state ^= xorshift_state << 13;
+    xorshift_state ^= xorshift_state >> 7;
+    xorshift_state ^= xorshift_state << 17;
+    return xorshift_state;
+}
+
+int main(void)
+{
+    /* 3^32 is the t32 modulus; (3^32 - 1) / 2 is its largest value. */
+    const int64_t t32_max = 926510094425920LL;
+    t32_t max32 = __ternary_tb2t_t32(t32_max);
+    t32_t one32 = __ternary_tb2t_t32(1);
+
+    expect_i64("tb2t_t32_wrap", __ternary_tt2b_t32(__ternary_tb2t_t32(t32_max + 1)), -t32_max);
+    expect_i64("tb2t_t32_int64_min", __ternary_tt2b_t32(__ternary_tb2t_t32(INT64_MIN)),
+               INT64_MIN % (2 * t32_max + 1));
+    expect_i64("add_t32", __ternary_tt2b_t32(__ternary_add_t32(__ternary_tb2t_t32(40),
+                                                               __ternary_tb2t_t32(-13))), 27);
+    expect_i64("sub_t32", __ternary_tt2b_t32(__ternary_sub_t32(__ternary_tb2t_t32(-5),
+                                                               __ternary_tb2t_t32(8))), -13);
+    expect_i64("neg_t32", __ternary_tt2b_t32(__ternary_neg_t32(__ternary_tb2t_t32(121))), -121);
+    expect_i64("add_t32_wrap", __ternary_tt2b_t32(__ternary_add_t32(max32, one32)), -t32_max);
+    expect_i64("sub_t32_wrap",
+               __ternary_tt2b_t32(__ternary_sub_t32(__ternary_neg_t32(max32), one32)), t32_max);
+
+    /* Reserved 11 codes read as +1, so 0x...57 (low trit 11) is the same as 0x...56. */
+    expect_u64("add_t32_reserved",
+               (uint64_t)__ternary_add_t32((t32_t)0x5555555555555557ULL, one32),
+               (uint64_t)__ternary_tb2t_t32(2));
+
+    expect_i64("cmp_t32_order", __ternary_cmp_t32(__ternary_tb2t_t32(-t32_max), max32), -1);
+    expect_i64("cmp_t32_reserved",
+               __ternary_cmp_t32((t32_t)0x5555555555555557ULL, __ternary_tb2t_t32(1)), 0);
+    expect_u64("cmplt_t32", (uint64_t)__ternary_cmplt_t32(one32, max32),
+               (uint64_t)__ternary_tb2t_t32(-1));
+    expect_u64("cmpeq_t32", (uint64_t)__ternary_cmpeq_t32(one32, max32),
+               (uint64_t)__ternary_tb2t_t32(0));
+
+    for (int i = 0; i < 10000; ++i) {
+        int64_t a = (int64_t)(next_random() % (2U * (uint64_t)t32_max + 1U)) - t32_max;
+        int64_t b = (int64_t)(next_random() % (2U * (uint64_t)t32_max + 1U)) - t32_max;
+        int64_t sum = a + b;
+        if (sum > t32_max)
+            sum -= 2 * t32_max + 1;
+        else if (sum < -t32_max)
+            sum += 2 * t32_max + 1;
+        t32_t pa = __ternary_tb2t_t32(a);
+        t32_t pb = __ternary_tb2t_t32(b);
+        expect_i64("add_t32_random", __ternary_tt2b_t32(__ternary_add_t32(pa, pb)), sum);
+        expect_i64("cmp_t32_random", __ternary_cmp_t32(pa, pb), (a > b) - (a < b));
+        expect_u64("sub_t32_random",
+                   (uint64_t)__ternary_sub_t32(__ternary_add_t32(pa, pb), pb), (uint64_t)pa);
+    }
+
+    /* Trit shifts scale by powers of three; shr repeats the top trit. */
+    expect_i64("shl_t32", __ternary_tt2b_t32(__ternary_shl_t32(__ternary_tb2t_t32(5), 2)), 45);
+    expect_i64("shr_t32", __ternary_tt2b_t32(__ternary_shr_t32(__ternary_tb2t_t32(-45), 2)), -5);
+    expect_u64("shr_t32_fill", (uint64_t)__ternary_shr_t32(__ternary_neg_t32(max32), 3),
+               (uint64_t)__ternary_neg_t32(max32));
+    expect_u64("rol_ror_t32",
+               (uint64_t)__ternary_ror_t32(__ternary_rol_t32((t32_t)0x5555555555555557ULL, 7), 7),
+               (uint64_t)__ternary_tb2t_t32(1));
+    expect_u64("shl_t32_count_mod", (uint64_t)__ternary_shl_t32(one32, 33),
+               (uint64_t)__ternary_shl_t32(one32, 1));
+
+    expect_i64("add_t64", __ternary_tt2b_t64(__ternary_add_t64(__ternary_tb2t_t64(INT64_C(1) << 40),
+                                                               __ternary_tb2t_t64(-7))),
+               (INT64_C(1) << 40) - 7);
+    expect_i64("sub_t64", __ternary_tt2b_t64(__ternary_sub_t64(__ternary_tb2t_t64(3),
+                                                               __ternary_tb2t_t64(10))), -7);
+    expect_i64("neg_t64", __ternary_tt2b_t64(__ternary_neg_t64(__ternary_tb2t_t64(-99))), 99);
+
+    /* Beyond int64: 3^30 * 3^30 is 3^60, i.e. +1 shifted up 60 trits. */
+    t64_t pow30 = __ternary_shl_t64(__ternary_tb2t_t64(1), 30);
+    t64_t pow60 = __ternary_mul_t64(pow30, pow30);
+    expect_u64("mul_t64_wide_lo", (uint64_t)pow60,
+               (uint64_t)__ternary_shl_t64(__ternary_tb2t_t64(1), 60));
+    expect_u64("mul_t64_wide_hi", (uint64_t)(pow60 >> 64),
+               (uint64_t)(__ternary_shl_t64(__ternary_tb2t_t64(1), 60) >> 64));
+    expect_u64("div_t64_wide", (uint64_t)__ternary_div_t64(pow60, pow30), (uint64_t)pow30);
+    expect_i64("mod_t64_wide",
+               __ternary_tt2b_t64(__ternary_mod_t64(__ternary_add_t64(pow60, __ternary_tb2t_t64(5)),
+                                                    pow30)), 5);
+    expect_i64("cmp_t64_wide", __ternary_cmp_t64(__ternary_neg_t64(pow60), pow30), -1);
+    expect_u64("shr_t64_wide", (uint64_t)__ternary_shr_t64(pow60, 30), (uint64_t)pow30);
+    expect_i64("tround_t64_wide", __ternary_tt2b_t64(__ternary_tround_t64(pow60, 58)), 9);
+    expect_i64("tround_t64_all", __ternary_tt2b_t64(__ternary_tround_t64(pow60, 64)), 0);
+
+    /* Bulk helpers match the scalar helpers element-wise, including in place. */
+    enum { BULK_N = 37 };
+    t32_t xa[BULK_N], xb[BULK_N], xc[BULK_N], xd[BULK_N], xr[BULK_N];
+    t64_t ya[BULK_N], yb[BULK_N], yc[BULK_N], yd[BULK_N], yr[BULK_N];
+    TERNARY_COND_T conds[BULK_N];
+    int cmps[BULK_N];
+    for (int i = 0; i < BULK_N; ++i) {
+        int64_t v = (int64_t)(next_random() % 2000001U) - 1000000;
+        xa[i] = __ternary_tb2t_t32(v);
+        xb[i] = __ternary_tb2t_t32((int64_t)(next_random() % 2000001U) - 1000000);
+        xc[i] = __ternary_tb2t_t32((int64_t)(i % 3) - 1);
+        xd[i] = (t32_t)next_random();
+        ya[i] = __ternary_tb2t_t64(v);
+        yb[i] = __ternary_tb2t_t64((int64_t)(next_random() % 2000001U) - 1000000);
+        yc[i] = __ternary_tb2t_t64((int64_t)(i % 3) - 1);
+        yd[i] = ((t64_t)next_random() << 64) | next_random();
+        conds[i] = (TERNARY_COND_T)(i % 2);
+    }
+#define CHECK_BULK2(OP, T, A, B, R) \
+    __ternary_##OP##_##T##_n(R, A, B, BULK_N); \
+    for (int i = 0; i < BULK_N; ++i) \
+        expect_u64(#OP "_" #T "_n", (uint64_t)R[i], (uint64_t)__ternary_##OP##_##T(A[i], B[i]));
+    CHECK_BULK2(add, t32, xa, xb, xr)
+    CHECK_BULK2(sub, t32, xa, xb, xr)
+    CHECK_BULK2(mul, t32, xa, xb, xr)
+    CHECK_BULK2(tmin, t32, xa, xd, xr)
+    CHECK_BULK2(tmax, t32, xa, xd, xr)
+    CHECK_BULK2(txor, t32, xc, xd, xr)
+    CHECK_BULK2(tequiv, t32, xc, xd, xr)
+    CHECK_BULK2(add, t64, ya, yb, yr)
+    CHECK_BULK2(sub, t64, ya, yb, yr)
+    CHECK_BULK2(mul, t64, ya, yb, yr)
+    CHECK_BULK2(tmin, t64, ya, yd, yr)
+    CHECK_BULK2(tmax, t64, ya, yd, yr)
+    CHECK_BULK2(txor, t64, yc, yd, yr)
+    CHECK_BULK2(tequiv, t64, yc, yd, yr)
+#undef CHECK_BULK2
+    __ternary_tmux_t32_n(xr, xc, xa, xb, xd, BULK_N);
+    __ternary_tmux_t64_n(yr, yc, ya, yb, yd, BULK_N);
+    for (int i = 0; i < BULK_N; ++i) {
+        expect_u64("tmux_t32_n", (uint64_t)xr[i],
+                   (uint64_t)__ternary_tmux_t32(xc[i], xa[i], xb[i], xd[i]));
+        expect_u64("tmux_t64_n", (uint64_t)(yr[i] >> 64),
+                   (uint64_t)(__ternary_tmux_t64(yc[i], ya[i], yb[i], yd[i]) >> 64));
+    }
+    __ternary_tmuladd_t32_n(xr, xa, xb, xc, BULK_N);
+    __ternary_tmuladd_t64_n(yr, ya, yb, yc, BULK_N);
+    for (int i = 0; i < BULK_N; ++i) {
+        expect_u64("tmuladd_t32_n", (uint64_t)xr[i],
+                   (uint64_t)__ternary_tmuladd_t32(xa[i], xb[i], xc[i]));
+        expect_u64("tmuladd_t64_n", (uint64_t)yr[i],
+                   (uint64_t)__ternary_tmuladd_t64(ya[i], yb[i], yc[i]));
+    }
+    __ternary_cmp_t32_n(cmps, xa, xb, BULK_N);
+    for (int i = 0; i < BULK_N; ++i)
+        expect_i64("cmp_t32_n", cmps[i], __ternary_cmp_t32(xa[i], xb[i]));
+    __ternary_cmp_t64_n(cmps, ya, yb, BULK_N);
+    for (int i = 0; i < BULK_N; ++i)
+        expect_i64("cmp_t64_n", cmps[i], __ternary_cmp_t64(ya[i], yb[i]));
+    __ternary_select_t32_n(xr, conds, xa, xb, BULK_N);
+    __ternary_select_t64_n(yr, conds, ya, yb, BULK_N);
+    for (int i = 0; i < BULK_N; ++i) {
+        expect_u64("select_t32_n", (uint64_t)xr[i], (uint64_t)(i % 2 ? xa[i] : xb[i]));
+        expect_u64("select_t64_n", (uint64_t)yr[i], (uint64_t)(i % 2 ? ya[i] : yb[i]));
+    }
+    for (int i = 0; i < BULK_N; ++i)
+        xr[i] = xa[i];
+    __ternary_neg_t32_n(xr, xr, BULK_N);
+    __ternary_add_t32_n(xr, xr, xa, BULK_N);
+    __ternary_neg_t64_n(yr, ya, BULK_N);
+    for (int i = 0; i < BULK_N; ++i) {
+        expect_u64("neg_add_t32_n_in_place", (uint64_t)xr[i], (uint64_t)__ternary_tb2t_t32(0));
+        expect_u64("neg_t64_n", (uint64_t)yr[i], (uint64_t)__ternary_neg_t64(ya[i]));
+    }
+
+    if (fail_count == 0) {
+        printf("packed arithmetic tests passed\n");
+        return 0;
+    }
+    return 1;
+}
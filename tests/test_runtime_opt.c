@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "ternary_runtime.h"
+#include "../runtime/ternary_runtime_opt.h"
+
+static int fail_count = 0;
+
+static void expect_u64(const char *name, uint64_t got, uint64_t expect)
+{
+    if (got != expect) {
+        fprintf(stderr, "FAIL %s: got 0x%016" PRIx64 " expect 0x%016" PRIx64 "\n",
+                name, got, expect);
+        fail_count++;
+    }
+}
+
+static uint64_t xorshift_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t next_random(void)
+{
+    xorshift_state ^= xorshift_state << 13;
+    xorshift_state ^= xorshift_state >> 7;
+    xorshift_state ^= xorshift_state << 17;
+    return xorshift_state;
+}
+
+/* Trit-at-a-time reference for the pos/neg split; 11 reads as +1. */
+static void reference_split(uint64_t packed, unsigned trits, uint64_t *pos, uint64_t *neg)
+{
+    *pos = 0;
+    *neg = 0;
+    for (unsigned i = 0; i < trits && i < 32; ++i) {
+        unsigned code = (unsigned)(packed >> (2 * i)) & 3U;
+        if (code >= 2)
+            *pos |= UINT64_C(1) << i;
+        else if (code == 0)
+            *neg |= UINT64_C(1) << i;
+    }
+}
+
+/* Rewrites reserved 11 codes as 10 (+1), the form join produces. */
+static uint64_t canonical(uint64_t packed)
+{
+    return packed & ~(packed & (packed >> 1) & 0x5555555555555555ULL);
+}
+
+static void check_random_words(void)
+{
+    for (int i = 0; i < 10000; ++i) {
+        uint64_t lo = next_random();
+        uint64_t hi = next_random();
+        uint64_t pos, neg, hi_pos, hi_neg;
+
+        reference_split(lo, 32, &pos, &neg);
+        ternary_masks32_t m = ternary_split_t32((t32_t)lo);
+        expect_u64("split_t32_random_pos", m.pos, pos);
+        expect_u64("split_t32_random_neg", m.neg, neg);
+        expect_u64("roundtrip_t32_random", (uint64_t)ternary_join_t32(m), canonical(lo));
+
+        t64_t wide = ((t64_t)hi << 64) | lo;
+        ternary_masks64_t w = ternary_split_t64(wide);
+        reference_split(hi, 32, &hi_pos, &hi_neg);
+        expect_u64("split_t64_random_pos", w.pos, (hi_pos << 32) | pos);
+        expect_u64("split_t64_random_neg", w.neg, (hi_neg << 32) | neg);
+        t64_t joined = ternary_join_t64(w);
+        expect_u64("roundtrip_t64_random_lo", (uint64_t)joined, canonical(lo));
+        expect_u64("roundtrip_t64_random_hi", (uint64_t)(joined >> 64), canonical(hi));
+
+#ifdef TERNARY_RUNTIME_DISPATCH
+        expect_u64("tnet_t32_variant", (uint64_t)__ternary_tnet_t32((t32_t)lo),
+                   (uint64_t)__ternary_tnet_t32_generic((t32_t)lo));
+        expect_u64("tnet_t64_variant", (uint64_t)__ternary_tnet_t64(wide),
+                   (uint64_t)__ternary_tnet_t64_generic(wide));
+#endif
+    }
+}
+
+#ifdef TERNARY_RUNTIME_DISPATCH
+/* The selected bulk variant must match the portable loop, including lengths
+ * that leave a vector remainder. */
+static void check_bulk_variants(void)
+{
+    enum { N = 67 };
+    t32_t a[N], b[N], c[N], d[N], got[N], want[N];
+    TERNARY_COND_T cond[N];
+    int got_cmp[N], want_cmp[N];
+
+    for (int i = 0; i < N; ++i) {
+        a[i] = (t32_t)next_random();
+        b[i] = (t32_t)next_random();
+        c[i] = (t32_t)next_random();
+        d[i] = (t32_t)next_random();
+        cond[i] = (TERNARY_COND_T)(next_random() % 3) - 1;
+    }
+#define CHECK_VARIANT(OP, ...) \
+    __ternary_##OP##_t32_n(got, __VA_ARGS__, N); \
+    __ternary_##OP##_t32_n_generic(want, __VA_ARGS__, N); \
+    for (int i = 0; i < N; ++i) \
+        expect_u64(#OP "_t32_n_variant", got[i], want[i]);
+    CHECK_VARIANT(add, a, b)
+    CHECK_VARIANT(sub, a, b)
+    CHECK_VARIANT(neg, a)
+    CHECK_VARIANT(tmin, a, b)
+    CHECK_VARIANT(tmax, a, b)
+    CHECK_VARIANT(txor, a, b)
+    CHECK_VARIANT(tequiv, a, b)
+    CHECK_VARIANT(tmux, a, b, c, d)
+    CHECK_VARIANT(select, cond, a, b)
+#undef CHECK_VARIANT
+    __ternary_cmp_t32_n(got_cmp, a, b, N);
+    __ternary_cmp_t32_n_generic(want_cmp, a, b, N);
+    for (int i = 0; i < N; ++i)
+        expect_u64("cmp_t32_n_variant", (uint64_t)got_cmp[i], (uint64_t)want_cmp[i]);
+}
+#endif
+
+int main(void)
+{
+    ternary_masks32_t m = ternary_split_t32(__ternary_tb2t_t32(0));
+    expect_u64("split_t32_zero_pos", m.pos, 0);
+    expect_u64("split_t32_zero_neg", m.neg, 0);
+
+    /* 4 = +1 +1 in balanced ternary; -4 = -1 -1. */
+    m = ternary_split_t32(__ternary_tb2t_t32(4));
+    expect_u64("split_t32_four_pos", m.pos, 0x3);
+    expect_u64("split_t32_four_neg", m.neg, 0);
+    m = ternary_split_t32(__ternary_tb2t_t32(-4));
+    expect_u64("split_t32_minus_four_pos", m.pos, 0);
+    expect_u64("split_t32_minus_four_neg", m.neg, 0x3);
+
+    /* The reserved 11 code splits as +1 and joins back canonical. */
+    m = ternary_split_t32((t32_t)0x5555555555555557ULL);
+    expect_u64("split_t32_reserved", m.pos, 0x1);
+    expect_u64("join_t32_reserved", (uint64_t)ternary_join_t32(m),
+               (uint64_t)__ternary_tb2t_t32(1));
+
+    /* Overlapping masks join as +1. */
+    m.pos = 0x1;
+    m.neg = 0x1;
+    expect_u64("join_t32_overlap", (uint64_t)ternary_join_t32(m), (uint64_t)__ternary_tb2t_t32(1));
+
+    /* Every variant the CPU supports must agree with the references. */
+    for (int isa = TERNARY_ISA_SCALAR; isa <= TERNARY_ISA_AVX512; ++isa) {
+        if (ternary_runtime_select_isa((ternary_isa_t)isa) != (ternary_isa_t)isa)
+            continue;
+        check_random_words();
+#ifdef TERNARY_RUNTIME_DISPATCH
+        check_bulk_variants();
+#endif
+    }
+
+    if (fail_count == 0) {
+        printf("optimized runtime tests passed\n");
+        return 0;
+    }
+    return 1;
+}
@@ -17,22 +17,22 @@ extern float __builtin_ternary_t2f(t32_t v);
 extern t32_t __builtin_ternary_f2t(float v);
 
 int test_integral(int cond, int a, int b) {
-    // This will be lowered to __ternary_select_i32(cond, a, b)
+    // With -select=all this is lowered to __ternary_select_i32(cond, a, b)
     return cond ? a : b;
 }
 
 unsigned int test_unsigned(int cond, unsigned int a, unsigned int b) {
-    // This will be lowered to __ternary_select_u32(cond, a, b)
+    // With -select=all this is lowered to __ternary_select_u32(cond, a, b)
     return cond ? a : b;
 }
 
 float test_float(int cond, float a, float b) {
-    // This will be lowered to __ternary_select_f32(cond, a, b)
+    // With -select=all this is lowered to __ternary_select_f32(cond, a, b)
     return cond ? a : b;
 }
 
 double test_double(int cond, double a, double b) {
-    // This will be lowered to __ternary_select_f64(cond, a, b)
+    // With -select=all this is lowered to __ternary_select_f64(cond, a, b)
     return cond ? a : b;
 }
 